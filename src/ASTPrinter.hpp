@@ -9,44 +9,44 @@
 */
 #pragma once
 
-class ASTPrinter : public ExprVisitor, public StmtVisitor{
+class ASTPrinter : public ExprVisitor<std::string>, public StmtVisitor<std::string>{
     // Prints a constructed expression as a string
     // via the Visitor design pattern.
     // Supports expressions and statements
     public:
-        std::string print(std::shared_ptr<Expr> expr);
-        std::any visit(std::shared_ptr<Expr> expr) override;
-        std::string print(std::shared_ptr<Stmt> stmt);
-        std::any visit(std::shared_ptr<Stmt> stmt) override;
+        using ExprVisitor<std::string>::visit;
+        using StmtVisitor<std::string>::visit;
+        std::string print(Expr* expr);
+        std::string print(Stmt* stmt);
 
         // EXPRESSIONS
-        std::any visitLiteralExpr(std::shared_ptr<LiteralExpr> curr) override;
-        std::any visitGroupingExpr(std::shared_ptr<GroupingExpr> curr) override;
-        std::any visitUnaryExpr(std::shared_ptr<UnaryExpr> curr) override;
-        std::any visitBinaryExpr(std::shared_ptr<BinaryExpr> curr) override;
+        std::string visitLiteralExpr(LiteralExpr* curr) override;
+        std::string visitGroupingExpr(GroupingExpr* curr) override;
+        std::string visitUnaryExpr(UnaryExpr* curr) override;
+        std::string visitBinaryExpr(BinaryExpr* curr) override;
 
-        std::any visitVariableExpr(std::shared_ptr<VariableExpr> curr) override;
-        std::any visitAssignExpr(std::shared_ptr<AssignExpr> curr) override;
-        std::any visitLogicalExpr(std::shared_ptr<LogicalExpr> curr) override;
+        std::string visitVariableExpr(VariableExpr* curr) override;
+        std::string visitAssignExpr(AssignExpr* curr) override;
+        std::string visitLogicalExpr(LogicalExpr* curr) override;
 
-        std::any visitCallExpr(std::shared_ptr<CallExpr> curr) override;
-        std::any visitGetExpr(std::shared_ptr<GetExpr> curr) override;
-        std::any visitSetExpr(std::shared_ptr<SetExpr> curr) override;
-        std::any visitThisExpr(std::shared_ptr<ThisExpr> curr) override;
-        std::any visitSuperExpr(std::shared_ptr<SuperExpr> curr) override;
+        std::string visitCallExpr(CallExpr* curr) override;
+        std::string visitGetExpr(GetExpr* curr) override;
+        std::string visitSetExpr(SetExpr* curr) override;
+        std::string visitThisExpr(ThisExpr* curr) override;
+        std::string visitSuperExpr(SuperExpr* curr) override;
 
         // STATEMENTS
-        std::any visitExpressionStmt(std::shared_ptr<ExpressionStmt> curr) override;
-        std::any visitPrintStmt(std::shared_ptr<PrintStmt> curr) override;
-        std::any visitVarStmt(std::shared_ptr<VarStmt> curr) override;
-        std::any visitBlockStmt(std::shared_ptr<BlockStmt> curr) override;
+        std::string visitExpressionStmt(ExpressionStmt* curr) override;
+        std::string visitPrintStmt(PrintStmt* curr) override;
+        std::string visitVarStmt(VarStmt* curr) override;
+        std::string visitBlockStmt(BlockStmt* curr) override;
         
-        std::any visitIfStmt(std::shared_ptr<IfStmt> curr) override;
-        std::any visitWhileStmt(std::shared_ptr<WhileStmt> curr) override;
+        std::string visitIfStmt(IfStmt* curr) override;
+        std::string visitWhileStmt(WhileStmt* curr) override;
 
-        std::any visitFunctionStmt(std::shared_ptr<FunctionStmt> curr) override;
-        std::any visitReturnStmt(std::shared_ptr<ReturnStmt> curr) override;
-        std::any visitClassStmt(std::shared_ptr<ClassStmt> curr) override;
+        std::string visitFunctionStmt(FunctionStmt* curr) override;
+        std::string visitReturnStmt(ReturnStmt* curr) override;
+        std::string visitClassStmt(ClassStmt* curr) override;
     private:
         int currIndent = 0;
         int increment = 2;
@@ -0,0 +1,78 @@
+// requires tokens, which nodes refer to
+#include "token.hpp"
+
+// required for placement new and type traits
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#pragma once
+
+class AstArena{
+    // Owner of one compiled program: its tokens, and every Expr and Stmt parsed from them.
+    // Nodes are bump-allocated in blocks, refer to each other and to the tokens by raw pointers
+    // and references, and are all destroyed together with the arena.
+    /*
+        KEY NOTES:
+        1. The tokens must not be modified once parsing starts: nodes refer to them.
+        2. LoxFunctions point into the arena, so an arena that declared any function
+           must outlive them (see Lox::run).
+    */
+    public:
+        std::vector<Token> tokens;
+        bool hasFunctions = false;
+
+        AstArena(std::vector<Token> tokens) : tokens(std::move(tokens)) {}
+        AstArena(const AstArena&) = delete;
+        AstArena& operator=(const AstArena&) = delete;
+        ~AstArena(void){
+            for (auto it = destructors.rbegin(); it != destructors.rend(); it++) it->destroy(it->node);
+            for (char* block : blocks) ::operator delete(block);
+        }
+
+        template<typename T, typename... Args>
+        T* make(Args&&... args){
+            // constructs a node in the arena
+            T* node = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+            if constexpr (!std::is_trivially_destructible_v<T>)
+                destructors.push_back({node, [](void* ptr){ static_cast<T*>(ptr)->~T(); }});
+            nodeCount++;
+            return node;
+        }
+
+        // statistics
+        size_t nodes(void) const { return nodeCount; }
+        size_t bytesUsed(void) const { return used; }
+        size_t bytesReserved(void) const { return reserved; }
+
+    private:
+        static constexpr size_t blockSize = 1 << 15;
+        struct Destructor{
+            void* node;
+            void (*destroy)(void*);
+        };
+        std::vector<char*> blocks = {};
+        std::vector<Destructor> destructors = {};
+        char* next = nullptr;
+        char* end = nullptr;
+        size_t nodeCount = 0;
+        size_t used = 0;
+        size_t reserved = 0;
+
+        void* allocate(size_t size, size_t align){
+            size_t padding = (align - (size_t)next % align) % align;
+            if (next == nullptr || (size_t)(end - next) < padding + size){
+                const size_t length = size > blockSize ? size : blockSize;
+                next = static_cast<char*>(::operator new(length));
+                end = next + length;
+                blocks.push_back(next);
+                reserved += length;
+                padding = 0;
+            }
+            void* ptr = next + padding;
+            next += padding + size;
+            used += size;
+            return ptr;
+        }
+};
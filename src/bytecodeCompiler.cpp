@@ -0,0 +1,260 @@
+#include "bytecodeCompiler.hpp"
+
+namespace {
+    // stack effect of each instruction (calls also pop their arguments)
+    const int stackEffect[] = {
+        #define LOX_OPCODE_EFFECT(name, effect) effect,
+        LOX_OPCODES(LOX_OPCODE_EFFECT)
+        #undef LOX_OPCODE_EFFECT
+    };
+}
+
+Chunk* BytecodeCompiler::compile(std::vector<Stmt*>& statements, int frameSize){
+    // compiles a program, which ends with HALT
+    return compileBody(statements, frameSize, OP_HALT);
+}
+Chunk* BytecodeCompiler::compileBody(std::vector<Stmt*>& statements, int frameSize, OpCode end){
+    // compiles a function body (ending with 'return nil') or a program into a chunk of its own
+    Chunk* const enclosing = chunk;
+    const int enclosingDepth = depth;
+    std::unordered_map<std::uint64_t, std::uint32_t> enclosingConstants = std::move(constants);
+
+    chunk = arena.make<Chunk>();
+    chunk->frameSize = frameSize;
+    depth = 0;
+    constants = {};
+    compile(statements);
+    if (end == OP_RETURN) emit(OP_NIL);
+    emit(end);
+
+    Chunk* const compiled = chunk;
+    chunk = enclosing;
+    depth = enclosingDepth;
+    constants = std::move(enclosingConstants);
+    return compiled;
+}
+Chunk* BytecodeCompiler::compileFunction(FunctionStmt* function){
+    // the body of a function or method. the VM places the arguments in the first slots
+    // of the frame, after 'this' (see Resolver::resolveFunction), and boxes those captured
+    Chunk* compiled = compileBody(function->body, function->frameSize, OP_RETURN);
+    if (function->isMethod && function->thisSlot.kind == VariableSlot::BOXED)
+        compiled->boxed.push_back(function->thisSlot.index);
+    for (const VariableSlot& slot : function->paramSlots)
+        if (slot.kind == VariableSlot::BOXED) compiled->boxed.push_back(slot.index);
+    return compiled;
+}
+void BytecodeCompiler::compile(std::vector<Stmt*>& statements){
+    for (Stmt* statement : statements) visit(statement);
+}
+
+
+// ---EMITTERS---
+void BytecodeCompiler::write(std::uint32_t value, int bytes){
+    for (int i = 0; i < bytes; i++) chunk->code.push_back((value >> (8 * i)) & 0xff);
+}
+void BytecodeCompiler::emit(OpCode op){
+    chunk->code.push_back(op);
+    depth += stackEffect[op];
+    chunk->maxStack = std::max(chunk->maxStack, depth);
+}
+void BytecodeCompiler::emitLong(OpCode op, std::uint32_t operand){
+    emit(op);
+    write(operand, 4);
+}
+void BytecodeCompiler::emitCall(bool tail, CallExpr* curr){
+    // a method call invokes the method without binding it (see VM)
+    OpCode op = tail ? OP_TAIL_CALL : OP_CALL;
+    if (curr->callee->type == Expr::GET){
+        GetExpr* get = static_cast<GetExpr*>(curr->callee);
+        visit(get->expr);
+        emitLong(OP_GET_METHOD, expr(get));
+        op = tail ? OP_TAIL_INVOKE : OP_INVOKE;
+    }
+    else visit(curr->callee);
+    for (Expr* argument : curr->arguments) visit(argument);
+    emit(op);
+    write(curr->arguments.size(), 1);
+    write(expr(curr), 4);
+    depth -= (int)curr->arguments.size();
+}
+void BytecodeCompiler::emitSlot(OpCode local, OpCode boxed, OpCode upvalue, const VariableSlot& slot){
+    // accesses a local variable, wherever the Resolver placed it
+    switch (slot.kind){
+        case VariableSlot::LOCAL: return emitLong(local, slot.index);
+        case VariableSlot::BOXED: return emitLong(boxed, slot.index);
+        default: return emitLong(upvalue, slot.index);
+    }
+}
+std::uint32_t BytecodeCompiler::constant(const Object& obj){
+    // literals are numbers and (interned) strings: equal literals have the same payload
+    const std::uint64_t key = obj.bits ^ ((std::uint64_t)obj.type << 60);
+    auto it = constants.find(key);
+    if (it != constants.end() && chunk->constants[it->second].type == obj.type) return it->second;
+    chunk->constants.push_back(obj);
+    const std::uint32_t index = (std::uint32_t)chunk->constants.size() - 1;
+    constants[key] = index;
+    return index;
+}
+std::uint32_t BytecodeCompiler::expr(Expr* curr){
+    chunk->exprs.push_back(curr);
+    return (std::uint32_t)chunk->exprs.size() - 1;
+}
+std::uint32_t BytecodeCompiler::stmt(Stmt* curr){
+    chunk->stmts.push_back(curr);
+    return (std::uint32_t)chunk->stmts.size() - 1;
+}
+
+size_t BytecodeCompiler::emitJump(OpCode op){
+    emit(op);
+    write(0, 4);
+    return chunk->code.size() - 4;
+}
+void BytecodeCompiler::patchJump(size_t jump){
+    // jumps to the end of the code emitted so far
+    const std::uint32_t offset = (std::uint32_t)(chunk->code.size() - (jump + 4));
+    for (int i = 0; i < 4; i++) chunk->code[jump + i] = (offset >> (8 * i)) & 0xff;
+}
+void BytecodeCompiler::emitLoop(size_t start){
+    emit(OP_LOOP);
+    write((std::uint32_t)(chunk->code.size() + 4 - start), 4);
+}
+
+
+// ---EXPR CHILD CLASSES---
+void BytecodeCompiler::visitLiteralExpr(LiteralExpr* curr){
+    switch (curr->obj.type){
+        case Object::NIL: return emit(OP_NIL);
+        case Object::BOOL: return emit(curr->obj.literalBool ? OP_TRUE : OP_FALSE);
+        default: return emitLong(OP_CONSTANT, constant(curr->obj));
+    }
+}
+void BytecodeCompiler::visitGroupingExpr(GroupingExpr* curr){
+    visit(curr->expr);
+}
+void BytecodeCompiler::visitUnaryExpr(UnaryExpr* curr){
+    visit(curr->expr);
+    if (curr->op.type == Token::BANG) emit(OP_NOT);
+    else emitLong(OP_NEGATE, expr(curr));
+}
+void BytecodeCompiler::visitBinaryExpr(BinaryExpr* curr){
+    visit(curr->left);
+    visit(curr->right);
+    switch (curr->op.type){
+        case Token::EQUAL_EQUAL: return emit(OP_EQUAL);
+        case Token::BANG_EQUAL: return emit(OP_NOT_EQUAL);
+        case Token::GREATER: return emitLong(OP_GREATER, expr(curr));
+        case Token::GREATER_EQUAL: return emitLong(OP_GREATER_EQUAL, expr(curr));
+        case Token::LESS: return emitLong(OP_LESS, expr(curr));
+        case Token::LESS_EQUAL: return emitLong(OP_LESS_EQUAL, expr(curr));
+        case Token::PLUS: return emitLong(OP_ADD, expr(curr));
+        case Token::MINUS: return emitLong(OP_SUBTRACT, expr(curr));
+        case Token::STAR: return emitLong(OP_MULTIPLY, expr(curr));
+        default: return emitLong(OP_DIVIDE, expr(curr));
+    }
+}
+
+void BytecodeCompiler::visitVariableExpr(VariableExpr* curr){
+    if (curr->slot.kind == VariableSlot::GLOBAL) emitLong(OP_GET_GLOBAL, expr(curr));
+    else emitSlot(OP_GET_LOCAL, OP_GET_BOXED, OP_GET_UPVALUE, curr->slot);
+}
+void BytecodeCompiler::visitAssignExpr(AssignExpr* curr){
+    visit(curr->expr);
+    if (curr->slot.kind == VariableSlot::GLOBAL) emitLong(OP_SET_GLOBAL, expr(curr));
+    else emitSlot(OP_SET_LOCAL, OP_SET_BOXED, OP_SET_UPVALUE, curr->slot);
+}
+void BytecodeCompiler::visitLogicalExpr(LogicalExpr* curr){
+    // short circuit: keep the left operand as the value. otherwise pop it and evaluate the right
+    visit(curr->left);
+    const size_t jump = emitJump(curr->op.type == Token::OR ? OP_JUMP_IF_TRUE : OP_JUMP_IF_FALSE);
+    emit(OP_POP);
+    visit(curr->right);
+    patchJump(jump);
+}
+
+void BytecodeCompiler::visitCallExpr(CallExpr* curr){
+    emitCall(false, curr);
+}
+void BytecodeCompiler::visitGetExpr(GetExpr* curr){
+    visit(curr->expr);
+    emitLong(OP_GET_PROPERTY, expr(curr));
+}
+void BytecodeCompiler::visitSetExpr(SetExpr* curr){
+    visit(curr->expr);
+    const std::uint32_t index = expr(curr);
+    emitLong(OP_CHECK_INSTANCE, index);
+    visit(curr->value);
+    emitLong(OP_SET_PROPERTY, index);
+}
+void BytecodeCompiler::visitThisExpr(ThisExpr* curr){
+    emitSlot(OP_GET_LOCAL, OP_GET_BOXED, OP_GET_UPVALUE, curr->slot);
+}
+void BytecodeCompiler::visitSuperExpr(SuperExpr* curr){
+    emitLong(OP_SUPER, expr(curr));
+}
+
+
+// ---STMT CHILD CLASSES---
+void BytecodeCompiler::visitExpressionStmt(ExpressionStmt* curr){
+    // an assignment to a local whose value is unused stores it directly
+    if (curr->expr->type == Expr::ASSIGN){
+        AssignExpr* assign = static_cast<AssignExpr*>(curr->expr);
+        if (assign->slot.kind == VariableSlot::LOCAL){
+            visit(assign->expr);
+            return emitLong(OP_STORE_LOCAL, assign->slot.index);
+        }
+    }
+    visit(curr->expr);
+    emit(OP_POP);
+}
+void BytecodeCompiler::visitPrintStmt(PrintStmt* curr){
+    visit(curr->expr);
+    emit(OP_PRINT);
+}
+void BytecodeCompiler::visitVarStmt(VarStmt* curr){
+    if (curr->initializer) visit(curr->initializer);
+    else emit(OP_NIL);
+    switch (curr->slot.kind){
+        case VariableSlot::LOCAL: return emitLong(OP_STORE_LOCAL, curr->slot.index);
+        case VariableSlot::BOXED: return emitLong(OP_DEFINE_BOXED, curr->slot.index);
+        default: return emitLong(OP_DEFINE_GLOBAL, curr->slot.index);
+    }
+}
+void BytecodeCompiler::visitBlockStmt(BlockStmt* curr){
+    compile(curr->statements);
+}
+
+void BytecodeCompiler::visitIfStmt(IfStmt* curr){
+    visit(curr->condition);
+    const size_t elseJump = emitJump(OP_POP_JUMP_IF_FALSE);
+    visit(curr->thenBranch);
+    if (!curr->elseBranch) return patchJump(elseJump);
+    const size_t endJump = emitJump(OP_JUMP);
+    patchJump(elseJump);
+    visit(curr->elseBranch);
+    patchJump(endJump);
+}
+void BytecodeCompiler::visitWhileStmt(WhileStmt* curr){
+    const size_t start = chunk->code.size();
+    visit(curr->condition);
+    const size_t exitJump = emitJump(OP_POP_JUMP_IF_FALSE);
+    visit(curr->body);
+    emitLoop(start);
+    patchJump(exitJump);
+}
+
+void BytecodeCompiler::visitFunctionStmt(FunctionStmt* curr){
+    curr->chunk = compileFunction(curr);
+    emitLong(OP_FUNCTION, stmt(curr));
+}
+void BytecodeCompiler::visitReturnStmt(ReturnStmt* curr){
+    if (curr->tailCall){
+        emitCall(true, curr->tailCall);
+    }
+    else if (curr->expr) visit(curr->expr);
+    else emit(OP_NIL);
+    emit(OP_RETURN);
+}
+void BytecodeCompiler::visitClassStmt(ClassStmt* curr){
+    for (FunctionStmt* method : curr->methods) method->chunk = compileFunction(method);
+    emitLong(OP_CLASS, stmt(curr));
+}
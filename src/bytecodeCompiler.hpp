@@ -0,0 +1,81 @@
+// requires the instruction set and chunks
+#include "chunk.hpp"
+// chunks are allocated with the AST they were compiled from
+#include "astArena.hpp"
+
+// required for the constant pool of the chunk being compiled
+#include <unordered_map>
+
+#pragma once
+
+class BytecodeCompiler : public ExprVisitor<void>, public StmtVisitor<void>{
+    // Compiles a resolved AST into bytecode for the VM, via the Visitor design pattern.
+    // Every expression leaves exactly one value on the stack; every statement leaves none.
+    /*
+        KEY NOTES:
+        1. Slots, upvalues and globals are those assigned by the Resolver: the VM runs
+           every call in a frame of FunctionStmt::frameSize slots, laid out as for the Interpreter.
+        2. The bodies of functions and methods are compiled into FunctionStmt::chunk.
+           Chunks are allocated in the arena of the AST, and live as long as it does.
+        3. Literals are deduplicated within a chunk's constant pool.
+    */
+    public:
+        BytecodeCompiler(AstArena& arena) : arena(arena) {}
+        using ExprVisitor<void>::visit;
+        using StmtVisitor<void>::visit;
+        Chunk* compile(std::vector<Stmt*>& statements, int frameSize);
+
+        // EXPR CHILD CLASSES
+        void visitLiteralExpr(LiteralExpr* curr) override;
+        void visitGroupingExpr(GroupingExpr* curr) override;
+        void visitUnaryExpr(UnaryExpr* curr) override;
+        void visitBinaryExpr(BinaryExpr* curr) override;
+
+        void visitVariableExpr(VariableExpr* curr) override;
+        void visitAssignExpr(AssignExpr* curr) override;
+        void visitLogicalExpr(LogicalExpr* curr) override;
+
+        void visitCallExpr(CallExpr* curr) override;
+        void visitGetExpr(GetExpr* curr) override;
+        void visitSetExpr(SetExpr* curr) override;
+        void visitThisExpr(ThisExpr* curr) override;
+        void visitSuperExpr(SuperExpr* curr) override;
+
+        // STMT CHILD CLASSES
+        void visitExpressionStmt(ExpressionStmt* curr) override;
+        void visitPrintStmt(PrintStmt* curr) override;
+        void visitVarStmt(VarStmt* curr) override;
+        void visitBlockStmt(BlockStmt* curr) override;
+
+        void visitIfStmt(IfStmt* curr) override;
+        void visitWhileStmt(WhileStmt* curr) override;
+
+        void visitFunctionStmt(FunctionStmt* curr) override;
+        void visitReturnStmt(ReturnStmt* curr) override;
+        void visitClassStmt(ClassStmt* curr) override;
+
+    private:
+        AstArena& arena;
+        Chunk* chunk = nullptr;     // the chunk being compiled
+        int depth = 0;              // temporaries on the stack at this point of the chunk
+        std::unordered_map<std::uint64_t, std::uint32_t> constants = {};   // literals in the pool
+
+        Chunk* compileBody(std::vector<Stmt*>& statements, int frameSize, OpCode end);
+        Chunk* compileFunction(FunctionStmt* function);
+        void compile(std::vector<Stmt*>& statements);
+
+        // emitters. each keeps track of the depth of the stack
+        void emit(OpCode op);
+        void emitLong(OpCode op, std::uint32_t operand);
+        void emitCall(bool tail, CallExpr* curr);
+        void emitSlot(OpCode local, OpCode boxed, OpCode upvalue, const VariableSlot& slot);
+        std::uint32_t constant(const Object& obj);
+        std::uint32_t expr(Expr* curr);
+        std::uint32_t stmt(Stmt* curr);
+
+        // jumps are emitted with a placeholder offset, patched once the target is known
+        size_t emitJump(OpCode op);
+        void patchJump(size_t jump);
+        void emitLoop(size_t start);
+        void write(std::uint32_t value, int bytes);
+};
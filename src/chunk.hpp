@@ -0,0 +1,94 @@
+// requires expressions and statements, which instructions refer to
+#include "expr.hpp"
+#include "stmt.hpp"
+
+// required for fixed-width bytecode
+#include <cstdint>
+#include <vector>
+
+#pragma once
+
+/*
+    INSTRUCTION SET of the VM, as X(name, stack effect, operands).
+    Operands follow the opcode, little-endian:
+        s  slot of the current frame or index of an upvalue or a global (4 bytes)
+        n  number of arguments (1 byte)
+        k  index into the constant pool (4 bytes)
+        e  index into the table of expressions (4 bytes), for error messages and caches
+        d  index into the table of statements (4 bytes)
+        j  unsigned jump offset from the end of the instruction (4 bytes)
+    Expressions in [exprs] supply the token of a runtime error, and are handed
+    to the Interpreter wherever the VM shares its work (eg. Interpreter::binary).
+*/
+#define LOX_OPCODES(X)                                                                      \
+    /* constants */                                                                         \
+    X(CONSTANT, 1)          /* k: push constants[k] */                                      \
+    X(NIL, 1)                                                                               \
+    X(TRUE, 1)                                                                              \
+    X(FALSE, 1)                                                                             \
+    X(POP, -1)                                                                              \
+    /* variables */                                                                         \
+    X(GET_LOCAL, 1)         /* s */                                                         \
+    X(SET_LOCAL, 0)         /* s: assign, keeping the value */                              \
+    X(STORE_LOCAL, -1)      /* s: assign or define, popping the value */                    \
+    X(GET_BOXED, 1)         /* s: local captured by a closure */                            \
+    X(SET_BOXED, 0)         /* s */                                                         \
+    X(DEFINE_BOXED, -1)     /* s: define in a new box */                                    \
+    X(GET_UPVALUE, 1)       /* s */                                                         \
+    X(SET_UPVALUE, 0)       /* s */                                                         \
+    X(GET_GLOBAL, 1)        /* e: VariableExpr */                                           \
+    X(SET_GLOBAL, 0)        /* e: AssignExpr */                                             \
+    X(DEFINE_GLOBAL, -1)    /* s */                                                         \
+    /* operators. e: BinaryExpr or UnaryExpr */                                             \
+    X(EQUAL, -1)                                                                            \
+    X(NOT_EQUAL, -1)                                                                        \
+    X(GREATER, -1)          /* e */                                                         \
+    X(GREATER_EQUAL, -1)    /* e */                                                         \
+    X(LESS, -1)             /* e */                                                         \
+    X(LESS_EQUAL, -1)       /* e */                                                         \
+    X(ADD, -1)              /* e */                                                         \
+    X(SUBTRACT, -1)         /* e */                                                         \
+    X(MULTIPLY, -1)         /* e */                                                         \
+    X(DIVIDE, -1)           /* e */                                                         \
+    X(NOT, 0)                                                                               \
+    X(NEGATE, 0)            /* e */                                                         \
+    /* statements and control flow */                                                      \
+    X(PRINT, -1)                                                                            \
+    X(JUMP, 0)              /* j */                                                         \
+    X(JUMP_IF_FALSE, 0)     /* j: keeps the condition */                                    \
+    X(JUMP_IF_TRUE, 0)      /* j: keeps the condition */                                    \
+    X(POP_JUMP_IF_FALSE, -1) /* j */                                                        \
+    X(LOOP, 0)              /* j: backwards */                                              \
+    /* functions and classes */                                                             \
+    X(CALL, 0)              /* n e: pops the callee and n arguments, pushes the result */   \
+    X(TAIL_CALL, 0)         /* n e: CALL in the frame of the caller. followed by RETURN */  \
+    X(INVOKE, -1)           /* n e: CALL of the method and receiver pushed by GET_METHOD */ \
+    X(TAIL_INVOKE, -1)      /* n e: INVOKE in the frame of the caller */                    \
+    X(RETURN, -1)                                                                           \
+    X(FUNCTION, 0)          /* d: FunctionStmt, declared as the Interpreter does */         \
+    X(CLASS, 0)             /* d: ClassStmt, declared as the Interpreter does */            \
+    X(GET_PROPERTY, 0)      /* e: GetExpr */                                                \
+    X(GET_METHOD, 1)        /* e: GetExpr of a call. pushes the receiver (see INVOKE) */    \
+    X(CHECK_INSTANCE, 0)    /* e: SetExpr. checks the object before the value is evaluated */ \
+    X(SET_PROPERTY, -1)     /* e: SetExpr */                                                \
+    X(SUPER, 1)             /* e: SuperExpr */                                              \
+    X(HALT, 0)              /* end of the program */
+
+enum OpCode : std::uint8_t{
+    #define LOX_OPCODE_ENUM(name, effect) OP_##name,
+    LOX_OPCODES(LOX_OPCODE_ENUM)
+    #undef LOX_OPCODE_ENUM
+};
+
+class Chunk{
+    // Bytecode of a function body (or of a program), compiled by BytecodeCompiler
+    public:
+        std::vector<std::uint8_t> code = {};
+        std::vector<Object> constants = {};
+        std::vector<Expr*> exprs = {};
+        std::vector<Stmt*> stmts = {};
+        int frameSize = 0;      // slots of the frame (see FunctionStmt::frameSize)
+        int maxStack = 0;       // temporaries above the frame, at most
+        // slots of 'this' and of the parameters captured by closures, boxed on entry
+        std::vector<std::uint32_t> boxed = {};
+};
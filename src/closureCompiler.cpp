@@ -0,0 +1,409 @@
+#include "closureCompiler.hpp"
+
+namespace {
+    template<typename F>
+    class ExprClosure : public ExprCode{
+        // an ExprCode running a lambda, which holds everything bound at compile time
+        public:
+        F function;
+        ExprClosure(F function) : ExprCode(&run), function(std::move(function)) {}
+        static Object run(ExprCode* self, Interpreter& interpreter){
+            return static_cast<ExprClosure*>(self)->function(interpreter);
+        }
+    };
+    template<typename F>
+    class StmtClosure : public StmtCode{
+        public:
+        F function;
+        StmtClosure(F function) : StmtCode(&run), function(std::move(function)) {}
+        static Completion run(StmtCode* self, Interpreter& interpreter){
+            return static_cast<StmtClosure*>(self)->function(interpreter);
+        }
+    };
+
+    // shapes of the operands of a binary expression
+    // a local is read in place, so it is only used where no call can follow it (and grow the stack)
+    struct Local{
+        int index;
+        const Object& operator()(Interpreter& interpreter) const {
+            return interpreter.stack[interpreter.frameBase + index];
+        }
+    };
+    struct Constant{
+        Object value;
+        const Object& operator()(Interpreter& interpreter) const { return value; }
+    };
+    struct Any{
+        ExprCode* code;
+        Object operator()(Interpreter& interpreter) const { return (*code)(interpreter); }
+    };
+
+    // binary operators. numbers take the fast path;
+    // everything else (string concatenation, type errors) is left to Interpreter::binary
+    template<Object (*apply)(double, double)>
+    struct Numeric{
+        static Object run(Interpreter& interpreter, const Token& op, const Object& left, const Object& right){
+            if (left.type == Object::NUMBER && right.type == Object::NUMBER)
+                return apply(left.literalNumber, right.literalNumber);
+            return interpreter.binary(op, left, right);
+        }
+    };
+    Object add(double a, double b){ return Object::number(a + b); }
+    Object subtract(double a, double b){ return Object::number(a - b); }
+    Object multiply(double a, double b){ return Object::number(a * b); }
+    Object divide(double a, double b){ return Object::number(a / b); }
+    Object greater(double a, double b){ return Object::boolean(a > b); }
+    Object greaterEqual(double a, double b){ return Object::boolean(a >= b); }
+    Object less(double a, double b){ return Object::boolean(a < b); }
+    Object lessEqual(double a, double b){ return Object::boolean(a <= b); }
+
+    template<bool equal>
+    struct Equality{
+        static Object run(Interpreter& interpreter, const Token& op, const Object& left, const Object& right){
+            return Object::boolean(interpreter.isEqual(left, right) == equal);
+        }
+    };
+
+    Expr* ungroup(Expr* expr){
+        while (expr->type == Expr::GROUPING) expr = static_cast<GroupingExpr*>(expr)->expr;
+        return expr;
+    }
+    bool isLocal(Expr* expr){
+        return expr->type == Expr::VARIABLE && static_cast<VariableExpr*>(expr)->slot.kind == VariableSlot::LOCAL;
+    }
+}
+
+template<typename F>
+ExprCode* ClosureCompiler::expr(F function){
+    return arena.make<ExprClosure<F>>(std::move(function));
+}
+template<typename F>
+StmtCode* ClosureCompiler::stmt(F function){
+    return arena.make<StmtClosure<F>>(std::move(function));
+}
+
+
+// ---STATEMENTS---
+StmtCode* ClosureCompiler::compile(std::vector<Stmt*>& statements){
+    // a list of statements stops at the first that does not complete normally
+    std::vector<StmtCode*> codes = {};
+    for (Stmt* statement : statements) codes.push_back(compile(statement));
+    if (codes.size() == 1) return codes[0];
+    return stmt([codes](Interpreter& interpreter){
+        for (StmtCode* code : codes){
+            const Completion completion = (*code)(interpreter);
+            if (completion != Completion::NORMAL) return completion;
+        }
+        return Completion::NORMAL;
+    });
+}
+
+StmtCode* ClosureCompiler::compile(Stmt* statement){
+    switch (statement->type){
+        case Stmt::EXPRESSION:{
+            ExprCode* value = compile(static_cast<ExpressionStmt*>(statement)->expr);
+            return stmt([value](Interpreter& interpreter){
+                (*value)(interpreter);
+                return Completion::NORMAL;
+            });
+        }
+        case Stmt::PRINT:{
+            ExprCode* value = compile(static_cast<PrintStmt*>(statement)->expr);
+            return stmt([value](Interpreter& interpreter){
+                interpreter.print((*value)(interpreter));
+                return Completion::NORMAL;
+            });
+        }
+        case Stmt::VAR:{
+            VarStmt* curr = static_cast<VarStmt*>(statement);
+            ExprCode* initializer = curr->initializer ? compile(curr->initializer) : nullptr;
+            if (curr->slot.kind == VariableSlot::LOCAL && initializer){
+                const int index = curr->slot.index;
+                return stmt([index, initializer](Interpreter& interpreter){
+                    Object value = (*initializer)(interpreter);
+                    interpreter.stack[interpreter.frameBase + index] = std::move(value);
+                    return Completion::NORMAL;
+                });
+            }
+            return stmt([curr, initializer](Interpreter& interpreter){
+                interpreter.defineVariable(curr->slot, initializer ? (*initializer)(interpreter) : Object::nil());
+                return Completion::NORMAL;
+            });
+        }
+        case Stmt::BLOCK:
+            return compile(static_cast<BlockStmt*>(statement)->statements);
+
+        case Stmt::IF:{
+            IfStmt* curr = static_cast<IfStmt*>(statement);
+            ExprCode* condition = compile(curr->condition);
+            StmtCode* thenBranch = compile(curr->thenBranch);
+            if (!curr->elseBranch){
+                return stmt([condition, thenBranch](Interpreter& interpreter){
+                    if (interpreter.isTruthy((*condition)(interpreter))) return (*thenBranch)(interpreter);
+                    return Completion::NORMAL;
+                });
+            }
+            StmtCode* elseBranch = compile(curr->elseBranch);
+            return stmt([condition, thenBranch, elseBranch](Interpreter& interpreter){
+                if (interpreter.isTruthy((*condition)(interpreter))) return (*thenBranch)(interpreter);
+                return (*elseBranch)(interpreter);
+            });
+        }
+        case Stmt::WHILE:{
+            WhileStmt* curr = static_cast<WhileStmt*>(statement);
+            ExprCode* condition = compile(curr->condition);
+            StmtCode* body = compile(curr->body);
+            return stmt([condition, body](Interpreter& interpreter){
+                while (interpreter.isTruthy((*condition)(interpreter))){
+                    const Completion completion = (*body)(interpreter);
+                    if (completion != Completion::NORMAL) return completion;
+                }
+                return Completion::NORMAL;
+            });
+        }
+
+        case Stmt::FUNCTION:{
+            // the function itself is created by the Interpreter, and runs the compiled body
+            FunctionStmt* curr = static_cast<FunctionStmt*>(statement);
+            curr->code = compile(curr->body);
+            return stmt([curr](Interpreter& interpreter){
+                return interpreter.visitFunctionStmt(curr);
+            });
+        }
+        case Stmt::RETURN:{
+            ReturnStmt* curr = static_cast<ReturnStmt*>(statement);
+            if (curr->tailCall && curr->tailCall->callee->type == Expr::GET){
+                CallExpr* call = curr->tailCall;
+                GetExpr* get = static_cast<GetExpr*>(call->callee);
+                ExprCode* object = compile(get->expr);
+                std::vector<ExprCode*> arguments = {};
+                for (Expr* argument : call->arguments) arguments.push_back(compile(argument));
+                return stmt([call, get, object, arguments](Interpreter& interpreter){
+                    Object obj = (*object)(interpreter);
+                    LoxFunction* method = interpreter.invokedMethod(get, obj);
+                    Object function = method ? Object::nil() : interpreter.getProperty(get, obj);
+                    ArgumentBuffer values(arguments.size());
+                    for (size_t i = 0; i < arguments.size(); i++) values[i] = (*arguments[i])(interpreter);
+                    if (method) return interpreter.returnInvoke(call, method, obj, values.span());
+                    return interpreter.returnCall(call, function, values.span());
+                });
+            }
+            if (curr->tailCall){
+                CallExpr* call = curr->tailCall;
+                ExprCode* callee = compile(call->callee);
+                std::vector<ExprCode*> arguments = {};
+                for (Expr* argument : call->arguments) arguments.push_back(compile(argument));
+                return stmt([call, callee, arguments](Interpreter& interpreter){
+                    Object function = (*callee)(interpreter);
+                    ArgumentBuffer values(arguments.size());
+                    for (size_t i = 0; i < arguments.size(); i++) values[i] = (*arguments[i])(interpreter);
+                    return interpreter.returnCall(call, function, values.span());
+                });
+            }
+            ExprCode* value = curr->expr ? compile(curr->expr) : nullptr;
+            return stmt([value](Interpreter& interpreter){
+                interpreter.returnValue = value ? (*value)(interpreter) : Object::nil();
+                return Completion::RETURN;
+            });
+        }
+        default:{
+            ClassStmt* curr = static_cast<ClassStmt*>(statement);
+            for (FunctionStmt* method : curr->methods) method->code = compile(method->body);
+            return stmt([curr](Interpreter& interpreter){
+                return interpreter.visitClassStmt(curr);
+            });
+        }
+    }
+}
+
+
+// ---EXPRESSIONS---
+ExprCode* ClosureCompiler::compile(Expr* expression){
+    switch (expression->type){
+        case Expr::LITERAL:{
+            Object value = static_cast<LiteralExpr*>(expression)->obj;
+            return expr([value](Interpreter& interpreter){ return value; });
+        }
+        case Expr::GROUPING:
+            return compile(static_cast<GroupingExpr*>(expression)->expr);
+        case Expr::UNARY:{
+            UnaryExpr* curr = static_cast<UnaryExpr*>(expression);
+            ExprCode* operand = compile(curr->expr);
+            if (curr->op.type == Token::BANG){
+                return expr([operand](Interpreter& interpreter){
+                    return Object::boolean(!interpreter.isTruthy((*operand)(interpreter)));
+                });
+            }
+            const Token* op = &curr->op;
+            return expr([op, operand](Interpreter& interpreter){
+                Object value = (*operand)(interpreter);
+                if (value.type == Object::NUMBER) return Object::number(-value.literalNumber);
+                return interpreter.unary(*op, value);
+            });
+        }
+        case Expr::BINARY:
+            return compileBinary(static_cast<BinaryExpr*>(expression));
+
+        case Expr::VARIABLE:{
+            VariableExpr* curr = static_cast<VariableExpr*>(expression);
+            if (curr->slot.kind != VariableSlot::GLOBAL) return compileVariable(curr->slot);
+            return expr([curr](Interpreter& interpreter){ return interpreter.globalVariable(curr); });
+        }
+        case Expr::ASSIGN:{
+            AssignExpr* curr = static_cast<AssignExpr*>(expression);
+            ExprCode* value = compile(curr->expr);
+            if (curr->slot.kind == VariableSlot::LOCAL){
+                const int index = curr->slot.index;
+                return expr([index, value](Interpreter& interpreter){
+                    Object obj = (*value)(interpreter);
+                    interpreter.stack[interpreter.frameBase + index] = obj;
+                    return obj;
+                });
+            }
+            return expr([curr, value](Interpreter& interpreter){
+                Object obj = (*value)(interpreter);
+                interpreter.assign(curr, obj);
+                return obj;
+            });
+        }
+        case Expr::LOGICAL:{
+            LogicalExpr* curr = static_cast<LogicalExpr*>(expression);
+            ExprCode* left = compile(curr->left);
+            ExprCode* right = compile(curr->right);
+            if (curr->op.type == Token::OR){
+                return expr([left, right](Interpreter& interpreter){
+                    Object value = (*left)(interpreter);
+                    if (interpreter.isTruthy(value)) return value;
+                    return (*right)(interpreter);
+                });
+            }
+            return expr([left, right](Interpreter& interpreter){
+                Object value = (*left)(interpreter);
+                if (!interpreter.isTruthy(value)) return value;
+                return (*right)(interpreter);
+            });
+        }
+
+        case Expr::CALL:
+            return compileCall(static_cast<CallExpr*>(expression));
+        case Expr::GET:{
+            GetExpr* curr = static_cast<GetExpr*>(expression);
+            ExprCode* object = compile(curr->expr);
+            return expr([curr, object](Interpreter& interpreter){
+                return interpreter.getProperty(curr, (*object)(interpreter));
+            });
+        }
+        case Expr::SET:{
+            SetExpr* curr = static_cast<SetExpr*>(expression);
+            ExprCode* object = compile(curr->expr);
+            ExprCode* value = compile(curr->value);
+            return expr([curr, object, value](Interpreter& interpreter){
+                Object obj = (*object)(interpreter);
+                interpreter.checkInstance(curr, obj);
+                Object result = (*value)(interpreter);
+                interpreter.setProperty(curr, obj, result);
+                return result;
+            });
+        }
+        case Expr::THIS:
+            return compileVariable(static_cast<ThisExpr*>(expression)->slot);
+        default:{
+            SuperExpr* curr = static_cast<SuperExpr*>(expression);
+            return expr([curr](Interpreter& interpreter){ return interpreter.visitSuperExpr(curr); });
+        }
+    }
+}
+
+ExprCode* ClosureCompiler::compileVariable(const VariableSlot& slot){
+    // reads a local variable, from wherever the Resolver placed it
+    const int index = slot.index;
+    switch (slot.kind){
+        case VariableSlot::LOCAL:
+            return expr([index](Interpreter& interpreter){
+                return interpreter.stack[interpreter.frameBase + index];
+            });
+        case VariableSlot::BOXED:
+            return expr([index](Interpreter& interpreter){
+                return interpreter.stack[interpreter.frameBase + index].as<LoxUpvalue>()->value;
+            });
+        default:
+            return expr([index](Interpreter& interpreter){
+                return interpreter.closure->upvalues[index]->value;
+            });
+    }
+}
+
+ExprCode* ClosureCompiler::compileCall(CallExpr* curr){
+    if (curr->callee->type == Expr::GET){
+        // a method call: the method is invoked without binding it (see Interpreter::invoke)
+        GetExpr* get = static_cast<GetExpr*>(curr->callee);
+        ExprCode* object = compile(get->expr);
+        std::vector<ExprCode*> arguments = {};
+        for (Expr* argument : curr->arguments) arguments.push_back(compile(argument));
+        return expr([curr, get, object, arguments](Interpreter& interpreter){
+            Object obj = (*object)(interpreter);
+            LoxFunction* method = interpreter.invokedMethod(get, obj);
+            Object function = method ? Object::nil() : interpreter.getProperty(get, obj);
+            ArgumentBuffer values(arguments.size());
+            for (size_t i = 0; i < arguments.size(); i++) values[i] = (*arguments[i])(interpreter);
+            if (method) return interpreter.invoke(curr, method, obj, values.span());
+            return interpreter.call(curr, function, values.span());
+        });
+    }
+    ExprCode* callee = compile(curr->callee);
+    std::vector<ExprCode*> arguments = {};
+    for (Expr* argument : curr->arguments) arguments.push_back(compile(argument));
+    return expr([curr, callee, arguments](Interpreter& interpreter){
+        Object function = (*callee)(interpreter);
+        ArgumentBuffer values(arguments.size());
+        for (size_t i = 0; i < arguments.size(); i++) values[i] = (*arguments[i])(interpreter);
+        return interpreter.call(curr, function, values.span());
+    });
+}
+
+ExprCode* ClosureCompiler::compileBinary(BinaryExpr* curr){
+    // picks the shape of the operands: locals and literals are read directly,
+    // anything else is compiled and called
+    Expr* left = ungroup(curr->left);
+    Expr* right = ungroup(curr->right);
+    const bool leftLocal = isLocal(left);
+    const bool rightLocal = isLocal(right);
+    const bool rightConstant = right->type == Expr::LITERAL;
+
+    if (rightLocal || rightConstant){
+        auto rightOperand = [&](auto leftOperand){
+            if (rightLocal) return binary(curr->op, leftOperand, Local{static_cast<VariableExpr*>(right)->slot.index});
+            return binary(curr->op, leftOperand, Constant{static_cast<LiteralExpr*>(right)->obj});
+        };
+        if (leftLocal) return rightOperand(Local{static_cast<VariableExpr*>(left)->slot.index});
+        return rightOperand(Any{compile(left)});
+    }
+    return binary(curr->op, Any{compile(left)}, Any{compile(right)});
+}
+
+template<typename L, typename R>
+ExprCode* ClosureCompiler::binary(const Token& op, L left, R right){
+    switch (op.type){
+        case Token::PLUS: return operation<Numeric<add>>(op, left, right);
+        case Token::MINUS: return operation<Numeric<subtract>>(op, left, right);
+        case Token::STAR: return operation<Numeric<multiply>>(op, left, right);
+        case Token::SLASH: return operation<Numeric<divide>>(op, left, right);
+        case Token::GREATER: return operation<Numeric<greater>>(op, left, right);
+        case Token::GREATER_EQUAL: return operation<Numeric<greaterEqual>>(op, left, right);
+        case Token::LESS: return operation<Numeric<less>>(op, left, right);
+        case Token::LESS_EQUAL: return operation<Numeric<lessEqual>>(op, left, right);
+        case Token::EQUAL_EQUAL: return operation<Equality<true>>(op, left, right);
+        default: return operation<Equality<false>>(op, left, right);
+    }
+}
+
+template<typename Op, typename L, typename R>
+ExprCode* ClosureCompiler::operation(const Token& op, L left, R right){
+    const Token* token = &op;
+    return expr([token, left, right](Interpreter& interpreter){
+        // operands are evaluated left to right, as by the Interpreter
+        auto&& a = left(interpreter);
+        auto&& b = right(interpreter);
+        return Op::run(interpreter, *token, a, b);
+    });
+}
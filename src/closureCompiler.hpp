@@ -0,0 +1,69 @@
+// requires the Interpreter, whose state (globals, frames) and operations compiled code uses
+#include "interpreter.hpp"
+// compiled code is allocated with the AST it was compiled from
+#include "astArena.hpp"
+
+#pragma once
+
+class ExprCode{
+    // A compiled expression: a function, and the data it was bound to at compile time
+    // (compiled operands, slots, constants). Running it is a single indirect call.
+    public:
+        using Function = Object (*)(ExprCode* self, Interpreter& interpreter);
+        Object operator()(Interpreter& interpreter){ return function(this, interpreter); }
+    protected:
+        ExprCode(Function function) : function(function) {}
+    private:
+        Function function;
+};
+
+class StmtCode{
+    // A compiled statement. Completes as the Interpreter's statements do.
+    public:
+        using Function = Completion (*)(StmtCode* self, Interpreter& interpreter);
+        Completion operator()(Interpreter& interpreter){ return function(this, interpreter); }
+    protected:
+        StmtCode(Function function) : function(function) {}
+    private:
+        Function function;
+};
+
+class ClosureCompiler{
+    // Compiles a resolved AST, once, into a tree of ExprCode and StmtCode closures.
+    // Each closure is specialised for its node: binary expressions for their operator and
+    // for the shape of their operands (local slots, literals), variables for the kind of slot.
+    // Executing the program is then a chain of direct calls: no visitor dispatch,
+    // and no switch on the operator or slot kind at runtime.
+    /*
+        KEY NOTES:
+        1. Closures are allocated in the arena of the AST, and live as long as it does.
+        2. The bodies of functions and methods are compiled into FunctionStmt::code,
+           which LoxFunction::call runs instead of walking the body.
+        3. Compiled code behaves exactly as the Interpreter does: it runs in the same frames,
+           and falls back to the Interpreter's operations (eg. Interpreter::binary)
+           for everything but the fast paths, including every runtime error.
+    */
+    public:
+        ClosureCompiler(AstArena& arena) : arena(arena) {}
+        StmtCode* compile(std::vector<Stmt*>& statements);
+
+    private:
+        AstArena& arena;
+
+        ExprCode* compile(Expr* expr);
+        StmtCode* compile(Stmt* stmt);
+
+        ExprCode* compileBinary(BinaryExpr* curr);
+        ExprCode* compileVariable(const VariableSlot& slot);
+        ExprCode* compileCall(CallExpr* curr);
+
+        template<typename L, typename R>
+        ExprCode* binary(const Token& op, L left, R right);
+        template<typename Op, typename L, typename R>
+        ExprCode* operation(const Token& op, L left, R right);
+
+        template<typename F>
+        ExprCode* expr(F function);
+        template<typename F>
+        StmtCode* stmt(F function);
+};
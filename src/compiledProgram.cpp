@@ -0,0 +1,126 @@
+#include "compiledProgram.hpp"
+// requires scanning and parsing, to rebuild the declarations of the program
+#include "scanner.hpp"
+#include "stmtParser.hpp"
+
+#include <iostream>
+
+namespace {
+    void numberExpr(Expr* expr, std::vector<Expr*>& exprs, std::vector<Stmt*>& stmts){
+        exprs.push_back(expr);
+        switch (expr->type){
+            case Expr::GROUPING:
+                numberExpr(static_cast<GroupingExpr*>(expr)->expr, exprs, stmts);
+                break;
+            case Expr::UNARY:
+                numberExpr(static_cast<UnaryExpr*>(expr)->expr, exprs, stmts);
+                break;
+            case Expr::BINARY:
+                numberExpr(static_cast<BinaryExpr*>(expr)->left, exprs, stmts);
+                numberExpr(static_cast<BinaryExpr*>(expr)->right, exprs, stmts);
+                break;
+            case Expr::ASSIGN:
+                numberExpr(static_cast<AssignExpr*>(expr)->expr, exprs, stmts);
+                break;
+            case Expr::LOGICAL:
+                numberExpr(static_cast<LogicalExpr*>(expr)->left, exprs, stmts);
+                numberExpr(static_cast<LogicalExpr*>(expr)->right, exprs, stmts);
+                break;
+            case Expr::CALL:{
+                CallExpr* curr = static_cast<CallExpr*>(expr);
+                numberExpr(curr->callee, exprs, stmts);
+                for (Expr* argument : curr->arguments) numberExpr(argument, exprs, stmts);
+                break;
+            }
+            case Expr::GET:
+                numberExpr(static_cast<GetExpr*>(expr)->expr, exprs, stmts);
+                break;
+            case Expr::SET:
+                numberExpr(static_cast<SetExpr*>(expr)->expr, exprs, stmts);
+                numberExpr(static_cast<SetExpr*>(expr)->value, exprs, stmts);
+                break;
+            default:
+                break;
+        }
+    }
+    void numberStmt(Stmt* stmt, std::vector<Expr*>& exprs, std::vector<Stmt*>& stmts){
+        stmts.push_back(stmt);
+        switch (stmt->type){
+            case Stmt::EXPRESSION:
+                numberExpr(static_cast<ExpressionStmt*>(stmt)->expr, exprs, stmts);
+                break;
+            case Stmt::PRINT:
+                numberExpr(static_cast<PrintStmt*>(stmt)->expr, exprs, stmts);
+                break;
+            case Stmt::VAR:{
+                VarStmt* curr = static_cast<VarStmt*>(stmt);
+                if (curr->initializer) numberExpr(curr->initializer, exprs, stmts);
+                break;
+            }
+            case Stmt::BLOCK:
+                for (Stmt* statement : static_cast<BlockStmt*>(stmt)->statements) numberStmt(statement, exprs, stmts);
+                break;
+            case Stmt::IF:{
+                IfStmt* curr = static_cast<IfStmt*>(stmt);
+                numberExpr(curr->condition, exprs, stmts);
+                numberStmt(curr->thenBranch, exprs, stmts);
+                if (curr->elseBranch) numberStmt(curr->elseBranch, exprs, stmts);
+                break;
+            }
+            case Stmt::WHILE:
+                numberExpr(static_cast<WhileStmt*>(stmt)->condition, exprs, stmts);
+                numberStmt(static_cast<WhileStmt*>(stmt)->body, exprs, stmts);
+                break;
+            case Stmt::FUNCTION:
+                for (Stmt* statement : static_cast<FunctionStmt*>(stmt)->body) numberStmt(statement, exprs, stmts);
+                break;
+            case Stmt::RETURN:{
+                ReturnStmt* curr = static_cast<ReturnStmt*>(stmt);
+                if (curr->expr) numberExpr(curr->expr, exprs, stmts);
+                break;
+            }
+            case Stmt::CLASS:{
+                ClassStmt* curr = static_cast<ClassStmt*>(stmt);
+                if (curr->superclass) numberExpr(curr->superclass, exprs, stmts);
+                for (FunctionStmt* method : curr->methods) numberStmt(method, exprs, stmts);
+                break;
+            }
+        }
+    }
+}
+
+void CompiledProgram::number(const std::vector<Stmt*>& statements, std::vector<Expr*>& exprs, std::vector<Stmt*>& stmts){
+    for (Stmt* statement : statements) numberStmt(statement, exprs, stmts);
+}
+
+int CompiledProgram::run(const char* source, Install install, StmtCode::Function main){
+    // Disable output buffering (runtime errors are interleaved with the output)
+    std::cout << std::unitbuf;
+    std::cerr << std::unitbuf;
+
+    // the front end runs as in Lox::run, on the source the program was compiled from
+    Scanner scanner(source);
+    std::vector<Token> tokens = scanner.scan();
+    if (scanner.hasError) return 65;
+    AstArena arena(std::move(tokens));
+    StmtParser parser(arena);
+    std::vector<Stmt*> statements = parser.parse();
+    if (parser.hasError) return 65;
+    Interpreter interpreter;
+    Resolver resolver(interpreter);
+    resolver.resolve(statements);
+    if (resolver.hasError) return 65;
+
+    CompiledProgram program;
+    number(statements, program.exprs, program.stmts);
+    install(program);
+    CompiledCode code(main);
+    try{
+        interpreter.interpret(&code, resolver.frameSize());
+    }
+    catch (LoxError::RuntimeError err){
+        err.print();
+        return 70;
+    }
+    return 0;
+}
@@ -0,0 +1,48 @@
+// requires the Interpreter, whose state (globals, frames) and operations compiled code uses
+#include "interpreter.hpp"
+// requires StmtCode, which bodies are installed as
+#include "closureCompiler.hpp"
+// requires upvalues and instances, which compiled code reads and writes
+#include "loxFunction.hpp"
+#include "loxClass.hpp"
+// required for the node tables
+#include <vector>
+
+#pragma once
+
+class CompiledCode : public StmtCode{
+    // A body compiled to a C++ function by CppCompiler
+    public:
+        CompiledCode(Function function) : StmtCode(function) {}
+};
+
+class CompiledProgram{
+    // The runtime of a Lox program compiled to C++ by CppCompiler (see `compile` in main.cpp).
+    // The generated translation unit is linked against the runtime library (everything but
+    // main.cpp), and its main() calls run().
+    /*
+        KEY NOTES:
+        1. The generated code embeds its source, which run() scans, parses and resolves again:
+           declarations (functions, classes) and the tokens of runtime errors are AST nodes,
+           and the Resolver lays out globals and frames exactly as it did when the program
+           was compiled. No tree is walked: every statement and expression runs as C++.
+        2. Nodes are referred to by index into [exprs] and [stmts], numbered in the same order
+           (see number()) by the compiler and at runtime.
+        3. The generated code installs the bodies of functions and methods into
+           FunctionStmt::code, which LoxFunction::call runs (as with the ClosureCompiler).
+    */
+    public:
+        std::vector<Expr*> exprs = {};
+        std::vector<Stmt*> stmts = {};
+        template<typename T>
+        T* expr(size_t index) const { return static_cast<T*>(exprs[index]); }
+        template<typename T>
+        T* stmt(size_t index) const { return static_cast<T*>(stmts[index]); }
+
+        // numbers every expression and statement of a program, in preorder
+        static void number(const std::vector<Stmt*>& statements, std::vector<Expr*>& exprs, std::vector<Stmt*>& stmts);
+
+        // runs a compiled program. returns its exit code (65 and 70 on errors, as the interpreter)
+        using Install = void (*)(CompiledProgram& program);
+        static int run(const char* source, Install install, StmtCode::Function main);
+};
@@ -0,0 +1,334 @@
+#include "cppCompiler.hpp"
+
+#include <cstdio>
+
+CppCompiler::CppCompiler(const std::vector<Stmt*>& statements) : statements(statements){
+    std::vector<Expr*> exprs = {};
+    std::vector<Stmt*> stmts = {};
+    CompiledProgram::number(statements, exprs, stmts);
+    for (size_t i = 0; i < exprs.size(); i++) exprIndex[exprs[i]] = i;
+    for (size_t i = 0; i < stmts.size(); i++) stmtIndex[stmts[i]] = i;
+}
+
+std::string CppCompiler::compile(const std::string& source){
+    const std::string main = function("program", statements);
+
+    std::ostringstream unit;
+    unit << "// A Lox program, compiled to C++ by `./lox.sh compile`. Build it against the runtime library:\n";
+    unit << "//     c++ -std=c++23 -O2 -I<repository>/src <this file> <repository>/build/libloxruntime.a\n";
+    unit << "#include \"compiledProgram.hpp\"\n\n";
+
+    // the source, for the front end (see CompiledProgram)
+    unit << "static const char source[] =\n    \"";
+    for (unsigned char c : source){
+        if (c == '\n') unit << "\\n\"\n    \"";
+        else if (c == '\\' || c == '"') unit << '\\' << c;
+        else if (c >= 0x20 && c < 0x7F) unit << c;
+        else{
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\%03o", c);
+            unit << escaped;
+        }
+    }
+    unit << "\";\n\n";
+
+    unit << "static CompiledProgram* P = nullptr;\n\n";
+    for (const std::string& text : functions) unit << text << "\n";
+    unit << main << "\n";
+
+    unit << "static void install(CompiledProgram& program){\n";
+    unit << "    P = &program;\n";
+    for (const std::string& text : installs) unit << "    " << text << "\n";
+    unit << "}\n\n";
+    unit << "int main(void){\n";
+    unit << "    return CompiledProgram::run(source, &install, &program);\n";
+    unit << "}\n";
+    return unit.str();
+}
+
+std::string CppCompiler::function(const std::string& name, const std::vector<Stmt*>& body){
+    // generates a C++ function running [body]. nested functions are generated first
+    std::ostringstream outer = std::move(out);
+    const int outerIndent = indent, outerTemps = temps;
+    out = std::ostringstream();
+    indent = 1;
+    temps = 0;
+
+    out << "static Completion " << name << "(StmtCode*, Interpreter& I){\n";
+    for (Stmt* stmt : body) statement(stmt);
+    line("return Completion::NORMAL;");
+    out << "}\n";
+    std::string text = out.str();
+
+    out = std::move(outer);
+    indent = outerIndent;
+    temps = outerTemps;
+    return text;
+}
+void CppCompiler::installBody(FunctionStmt* curr){
+    const std::string index = std::to_string(stmtIndex[curr]);
+    const std::string name = "fun" + index + "_" + curr->name.lexeme;
+    functions.push_back(function(name, curr->body)
+        + "static CompiledCode code" + index + "(&" + name + ");\n");
+    installs.push_back(node(curr, "FunctionStmt") + "->code = &code" + index + ";");
+}
+
+void CppCompiler::line(const std::string& text){
+    out << std::string(4 * indent, ' ') << text << "\n";
+}
+std::string CppCompiler::temp(void){
+    return "t" + std::to_string(temps++);
+}
+std::string CppCompiler::node(Expr* expr, const std::string& type){
+    return "P->expr<" + type + ">(" + std::to_string(exprIndex[expr]) + ")";
+}
+std::string CppCompiler::node(Stmt* stmt, const std::string& type){
+    return "P->stmt<" + type + ">(" + std::to_string(stmtIndex[stmt]) + ")";
+}
+std::string CppCompiler::number(double value){
+    // hexadecimal floating literals are exact
+    char text[32];
+    std::snprintf(text, sizeof(text), "%a", value);
+    return text;
+}
+
+
+// ---STATEMENTS---
+void CppCompiler::statement(Stmt* stmt){
+    switch (stmt->type){
+        case Stmt::EXPRESSION:
+            expression(static_cast<ExpressionStmt*>(stmt)->expr);
+            break;
+        case Stmt::PRINT:
+            line("I.print(" + expression(static_cast<PrintStmt*>(stmt)->expr) + ");");
+            break;
+        case Stmt::VAR:{
+            VarStmt* curr = static_cast<VarStmt*>(stmt);
+            const std::string value = curr->initializer ? expression(curr->initializer) : "Object::nil()";
+            if (curr->slot.kind == VariableSlot::LOCAL)
+                line("I.stack[I.frameBase + " + std::to_string(curr->slot.index) + "] = " + value + ";");
+            else
+                line("I.defineVariable(" + node(curr, "VarStmt") + "->slot, " + value + ");");
+            break;
+        }
+        case Stmt::BLOCK:
+            line("{");
+            indent++;
+            for (Stmt* statement : static_cast<BlockStmt*>(stmt)->statements) this->statement(statement);
+            indent--;
+            line("}");
+            break;
+
+        case Stmt::IF:{
+            IfStmt* curr = static_cast<IfStmt*>(stmt);
+            line("if (I.isTruthy(" + expression(curr->condition) + ")){");
+            indent++;
+            statement(curr->thenBranch);
+            indent--;
+            if (curr->elseBranch){
+                line("}");
+                line("else{");
+                indent++;
+                statement(curr->elseBranch);
+                indent--;
+            }
+            line("}");
+            break;
+        }
+        case Stmt::WHILE:{
+            // the condition is evaluated inside the loop, before every iteration
+            WhileStmt* curr = static_cast<WhileStmt*>(stmt);
+            line("while (true){");
+            indent++;
+            line("if (!I.isTruthy(" + expression(curr->condition) + ")) break;");
+            statement(curr->body);
+            indent--;
+            line("}");
+            break;
+        }
+
+        case Stmt::FUNCTION:{
+            // the function itself is created by the Interpreter, and runs the compiled body
+            FunctionStmt* curr = static_cast<FunctionStmt*>(stmt);
+            installBody(curr);
+            line("I.visitFunctionStmt(" + node(curr, "FunctionStmt") + ");");
+            break;
+        }
+        case Stmt::RETURN:{
+            ReturnStmt* curr = static_cast<ReturnStmt*>(stmt);
+            if (curr->tailCall && curr->tailCall->callee->type == Expr::GET){
+                std::string object, callee;
+                const std::string method = invoked(curr->tailCall, object, callee);
+                const std::string values = arguments(curr->tailCall);
+                const std::string call = node(curr->tailCall, "CallExpr");
+                line("return " + method + " ? I.returnInvoke(" + call + ", " + method + ", " + object + ", " + values
+                    + ") : I.returnCall(" + call + ", " + callee + ", " + values + ");");
+                break;
+            }
+            if (curr->tailCall){
+                const std::string callee = expression(curr->tailCall->callee);
+                const std::string values = arguments(curr->tailCall);
+                line("return I.returnCall(" + node(curr->tailCall, "CallExpr") + ", " + callee + ", " + values + ");");
+                break;
+            }
+            line("I.returnValue = " + (curr->expr ? expression(curr->expr) : std::string("Object::nil()")) + ";");
+            line("return Completion::RETURN;");
+            break;
+        }
+        case Stmt::CLASS:{
+            ClassStmt* curr = static_cast<ClassStmt*>(stmt);
+            for (FunctionStmt* method : curr->methods) installBody(method);
+            line("I.visitClassStmt(" + node(curr, "ClassStmt") + ");");
+            break;
+        }
+    }
+}
+
+
+// ---EXPRESSIONS---
+std::string CppCompiler::expression(Expr* expr){
+    // emits the evaluation of [expr], and returns the temporary holding its value
+    if (expr->type == Expr::GROUPING) return expression(static_cast<GroupingExpr*>(expr)->expr);
+    const std::string result = temp();
+    switch (expr->type){
+        case Expr::LITERAL:{
+            const Object& value = static_cast<LiteralExpr*>(expr)->obj;
+            if (value.type == Object::NUMBER) line("Object " + result + " = Object::number(" + number(value.literalNumber) + ");");
+            else if (value.type == Object::BOOL) line("Object " + result + " = Object::boolean(" + (value.literalBool ? "true" : "false") + ");");
+            else if (value.type == Object::NIL) line("Object " + result + " = Object::nil();");
+            else line("Object " + result + " = " + node(expr, "LiteralExpr") + "->obj;");
+            break;
+        }
+        case Expr::UNARY:{
+            UnaryExpr* curr = static_cast<UnaryExpr*>(expr);
+            const std::string operand = expression(curr->expr);
+            if (curr->op.type == Token::BANG)
+                line("Object " + result + " = Object::boolean(!I.isTruthy(" + operand + "));");
+            else
+                line("Object " + result + " = " + operand + ".type == Object::NUMBER ? Object::number(-" + operand
+                    + ".literalNumber) : I.unary(" + node(expr, "UnaryExpr") + "->op, " + operand + ");");
+            break;
+        }
+        case Expr::BINARY:{
+            // numbers take the fast path; everything else is left to Interpreter::binary
+            BinaryExpr* curr = static_cast<BinaryExpr*>(expr);
+            const std::string left = expression(curr->left);
+            const std::string right = expression(curr->right);
+            std::string op, kind = "number";
+            switch (curr->op.type){
+                case Token::PLUS: op = "+"; break;
+                case Token::MINUS: op = "-"; break;
+                case Token::STAR: op = "*"; break;
+                case Token::SLASH: op = "/"; break;
+                case Token::GREATER: op = ">"; kind = "boolean"; break;
+                case Token::GREATER_EQUAL: op = ">="; kind = "boolean"; break;
+                case Token::LESS: op = "<"; kind = "boolean"; break;
+                case Token::LESS_EQUAL: op = "<="; kind = "boolean"; break;
+                case Token::EQUAL_EQUAL:
+                    line("Object " + result + " = Object::boolean(I.isEqual(" + left + ", " + right + "));");
+                    return result;
+                default:
+                    line("Object " + result + " = Object::boolean(!I.isEqual(" + left + ", " + right + "));");
+                    return result;
+            }
+            line("Object " + result + " = " + left + ".type == Object::NUMBER && " + right + ".type == Object::NUMBER ?");
+            line("    Object::" + kind + "(" + left + ".literalNumber " + op + " " + right + ".literalNumber) : I.binary("
+                + node(expr, "BinaryExpr") + "->op, " + left + ", " + right + ");");
+            break;
+        }
+
+        case Expr::VARIABLE:
+            line("Object " + result + " = " + variable(static_cast<VariableExpr*>(expr)->slot, expr) + ";");
+            break;
+        case Expr::ASSIGN:{
+            AssignExpr* curr = static_cast<AssignExpr*>(expr);
+            const std::string value = expression(curr->expr);
+            if (curr->slot.kind == VariableSlot::LOCAL)
+                line("I.stack[I.frameBase + " + std::to_string(curr->slot.index) + "] = " + value + ";");
+            else
+                line("I.assign(" + node(expr, "AssignExpr") + ", " + value + ");");
+            return value;
+        }
+        case Expr::LOGICAL:{
+            // the right operand is only evaluated if the left does not decide the result
+            LogicalExpr* curr = static_cast<LogicalExpr*>(expr);
+            line("Object " + result + " = " + expression(curr->left) + ";");
+            line(std::string(curr->op.type == Token::OR ? "if (!" : "if (") + "I.isTruthy(" + result + ")){");
+            indent++;
+            line(result + " = " + expression(curr->right) + ";");
+            indent--;
+            line("}");
+            break;
+        }
+
+        case Expr::CALL:{
+            CallExpr* curr = static_cast<CallExpr*>(expr);
+            if (curr->callee->type == Expr::GET){
+                std::string object, callee;
+                const std::string method = invoked(curr, object, callee);
+                const std::string values = arguments(curr);
+                const std::string call = node(expr, "CallExpr");
+                line("Object " + result + " = " + method + " ? I.invoke(" + call + ", " + method + ", " + object + ", "
+                    + values + ") : I.call(" + call + ", " + callee + ", " + values + ");");
+                break;
+            }
+            const std::string callee = expression(curr->callee);
+            const std::string values = arguments(curr);
+            line("Object " + result + " = I.call(" + node(expr, "CallExpr") + ", " + callee + ", " + values + ");");
+            break;
+        }
+        case Expr::GET:{
+            const std::string object = expression(static_cast<GetExpr*>(expr)->expr);
+            line("Object " + result + " = I.getProperty(" + node(expr, "GetExpr") + ", " + object + ");");
+            break;
+        }
+        case Expr::SET:{
+            SetExpr* curr = static_cast<SetExpr*>(expr);
+            const std::string object = expression(curr->expr);
+            line("I.checkInstance(" + node(expr, "SetExpr") + ", " + object + ");");
+            const std::string value = expression(curr->value);
+            line("I.setProperty(" + node(expr, "SetExpr") + ", " + object + ", " + value + ");");
+            return value;
+        }
+        case Expr::THIS:
+            line("Object " + result + " = " + variable(static_cast<ThisExpr*>(expr)->slot, expr) + ";");
+            break;
+        case Expr::SUPER:
+            line("Object " + result + " = I.visitSuperExpr(" + node(expr, "SuperExpr") + ");");
+            break;
+        case Expr::GROUPING:
+            break;      // unwrapped above
+    }
+    return result;
+}
+
+std::string CppCompiler::variable(const VariableSlot& slot, Expr* expr){
+    // reads a variable, wherever the Resolver placed it
+    const std::string index = std::to_string(slot.index);
+    switch (slot.kind){
+        case VariableSlot::LOCAL: return "I.stack[I.frameBase + " + index + "]";
+        case VariableSlot::BOXED: return "I.stack[I.frameBase + " + index + "].as<LoxUpvalue>()->value";
+        case VariableSlot::UPVALUE: return "I.closure->upvalues[" + index + "]->value";
+        default: return "I.globalVariable(" + node(expr, "VariableExpr") + ")";
+    }
+}
+
+std::string CppCompiler::invoked(CallExpr* call, std::string& object, std::string& callee){
+    // evaluates the object of a method call, and looks up the method invoked on it
+    // (or, if the property is not a method, its value into [callee]). returns the method
+    GetExpr* get = static_cast<GetExpr*>(call->callee);
+    object = expression(get->expr);
+    const std::string method = "m" + std::to_string(temps++);
+    callee = temp();
+    line("LoxFunction* " + method + " = I.invokedMethod(" + node(get, "GetExpr") + ", " + object + ");");
+    line("Object " + callee + " = " + method + " ? Object::nil() : I.getProperty(" + node(get, "GetExpr") + ", " + object + ");");
+    return method;
+}
+std::string CppCompiler::arguments(CallExpr* call){
+    // evaluates the arguments of [call], in order, into an ArgumentBuffer. returns its span
+    const std::string values = "a" + std::to_string(temps++);
+    line("ArgumentBuffer " + values + "(" + std::to_string(call->arguments.size()) + ");");
+    for (size_t i = 0; i < call->arguments.size(); i++)
+        line(values + "[" + std::to_string(i) + "] = std::move(" + expression(call->arguments[i]) + ");");
+    return values + ".span()";
+}
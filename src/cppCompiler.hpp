@@ -0,0 +1,61 @@
+// requires expressions and statements, and the runtime the generated code is linked against
+#include "expr.hpp"
+#include "stmt.hpp"
+#include "compiledProgram.hpp"
+// required for the generated code
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#pragma once
+
+class CppCompiler{
+    // Compiles a resolved program ahead of time into a C++ translation unit, which is built
+    // against the runtime library into a native executable (see CompiledProgram).
+    /*
+        KEY NOTES:
+        1. Every function and method body becomes a C++ function completing as StmtCode does;
+           the program itself is one more. Control flow becomes C++ control flow:
+           'return' returns from the C++ function, 'while' is a C++ loop.
+        2. Expressions are lowered to sequences of C++ statements, each into a temporary,
+           so operands are evaluated left to right as by the Interpreter.
+        3. The generated code behaves exactly as the Interpreter does: it runs in the same frames,
+           with the fast paths on numbers and locals inline, and falls back to the Interpreter's
+           operations (eg. Interpreter::binary) for everything else, including every runtime error.
+    */
+    public:
+        CppCompiler(const std::vector<Stmt*>& statements);
+        // returns the translation unit of the program [statements] (compiled from [source])
+        std::string compile(const std::string& source);
+
+    private:
+        const std::vector<Stmt*>& statements;
+        // node indices, as CompiledProgram::number() assigns them
+        std::unordered_map<Expr*, size_t> exprIndex = {};
+        std::unordered_map<Stmt*, size_t> stmtIndex = {};
+
+        // generated functions, and the bodies installed into declarations
+        std::vector<std::string> functions = {};
+        std::vector<std::string> installs = {};
+
+        // the function being generated
+        std::ostringstream out;
+        int indent = 1;
+        int temps = 0;
+
+        std::string function(const std::string& name, const std::vector<Stmt*>& body);
+        void installBody(FunctionStmt* function);
+
+        void line(const std::string& text);
+        std::string temp(void);
+        std::string node(Expr* expr, const std::string& type);
+        std::string node(Stmt* stmt, const std::string& type);
+        static std::string number(double value);
+
+        void statement(Stmt* stmt);
+        std::string expression(Expr* expr);
+        std::string variable(const VariableSlot& slot, Expr* expr);
+        std::string invoked(CallExpr* call, std::string& object, std::string& callee);
+        std::string arguments(CallExpr* call);
+};
@@ -1,13 +1,10 @@
 
-// required for std::any for visitor design pattern
-#include <any>
-// required for smart pointers
-#include <memory>
-// required for std::move for smart pointers
-#include <utility>
-
-// requires tokens
+#include <vector>
+
+// requires tokens. nodes refer to the tokens owned by their AstArena
 #include "token.hpp"
+// requires the inline caches of property accesses
+#include "shape.hpp"
 
 #pragma once
 
@@ -55,137 +52,213 @@ class SetExpr;
 class ThisExpr;
 class SuperExpr;
 
+struct VariableSlot{
+    // static location of a variable, written into the node by the Resolver
+    //   GLOBAL:  [index] in the global table
+    //   LOCAL:   [index] in the frame of the current call
+    //   BOXED:   [index] in the frame of the current call, which holds a LoxUpvalue
+    //            (the variable is captured by a closure)
+    //   UPVALUE: [index] in the upvalues of the current closure
+    enum Kind : std::uint8_t { GLOBAL, LOCAL, BOXED, UPVALUE };
+    Kind kind = GLOBAL;
+    int index = -1;
+};
+
+// the user-defined functions a call site may cache
+class LoxFunction;
+
+struct CallCache{
+    // Inline cache of a call site (CallExpr): the callee last called there, whose arity
+    // has been checked (see Interpreter::checkCall), and the user-defined function it runs
+    // (nullptr for classes and native functions), which is called without virtual dispatch.
+    // The cache holds a reference to its callee: a cached address is never reused by
+    // another object, and the callee lives until the site calls something else.
+    Object callee;
+    LoxFunction* function = nullptr;
+
+    bool hit(const Object& obj) const { return obj.isObj() && obj.obj == callee.obj; }
+};
+
+template<typename R>
 class ExprVisitor{
     // Abstract class implementing the Visitor design pattern for Expr
+    // Each visit returns R directly (eg. Object for the Interpreter).
     public:
         virtual ~ExprVisitor(void) = default;
-        virtual std::any visit(std::shared_ptr<Expr> curr) = 0;
+        R visit(Expr* curr);
 
-        virtual std::any visitLiteralExpr(std::shared_ptr<LiteralExpr> curr) = 0;
-        virtual std::any visitGroupingExpr(std::shared_ptr<GroupingExpr> curr) = 0;
-        virtual std::any visitUnaryExpr(std::shared_ptr<UnaryExpr> curr) = 0;
-        virtual std::any visitBinaryExpr(std::shared_ptr<BinaryExpr> curr) = 0;
+        virtual R visitLiteralExpr(LiteralExpr* curr) = 0;
+        virtual R visitGroupingExpr(GroupingExpr* curr) = 0;
+        virtual R visitUnaryExpr(UnaryExpr* curr) = 0;
+        virtual R visitBinaryExpr(BinaryExpr* curr) = 0;
 
-        virtual std::any visitVariableExpr(std::shared_ptr<VariableExpr> curr) = 0;
-        virtual std::any visitAssignExpr(std::shared_ptr<AssignExpr> curr) = 0;
-        virtual std::any visitLogicalExpr(std::shared_ptr<LogicalExpr> curr) = 0;
+        virtual R visitVariableExpr(VariableExpr* curr) = 0;
+        virtual R visitAssignExpr(AssignExpr* curr) = 0;
+        virtual R visitLogicalExpr(LogicalExpr* curr) = 0;
 
-        virtual std::any visitCallExpr(std::shared_ptr<CallExpr> curr) = 0;
-        virtual std::any visitGetExpr(std::shared_ptr<GetExpr> curr) = 0;
-        virtual std::any visitSetExpr(std::shared_ptr<SetExpr> curr) = 0;
-        virtual std::any visitThisExpr(std::shared_ptr<ThisExpr> curr) = 0;
-        virtual std::any visitSuperExpr(std::shared_ptr<SuperExpr> curr) = 0;
+        virtual R visitCallExpr(CallExpr* curr) = 0;
+        virtual R visitGetExpr(GetExpr* curr) = 0;
+        virtual R visitSetExpr(SetExpr* curr) = 0;
+        virtual R visitThisExpr(ThisExpr* curr) = 0;
+        virtual R visitSuperExpr(SuperExpr* curr) = 0;
 };
 
 class Expr{
     // Abstract class implementing expressions.
-    // Supports the Visitor design pattern via ExprVisitor, which is passed by reference.
+    // Supports the Visitor design pattern via ExprVisitor, which dispatches on [type].
     public:
+        enum ExprType : std::uint8_t {
+            LITERAL, GROUPING, UNARY, BINARY,
+            VARIABLE, ASSIGN, LOGICAL,
+            CALL, GET, SET, THIS, SUPER
+        };
+        const ExprType type;
+        Expr(ExprType type) : type(type) {}
         virtual ~Expr(void) = default;
-        virtual std::any accept(ExprVisitor& v) = 0;
 };
 
 
 // ---CHILD CLASSES (PURE EXPRESSIONS)---
-class LiteralExpr : public Expr, public std::enable_shared_from_this<LiteralExpr>{
+class LiteralExpr : public Expr{
     // An expression of a literal.
     public:
         Object obj;
-        LiteralExpr(Object obj) : obj(obj) {}
-        std::any accept(ExprVisitor& v) override { return v.visitLiteralExpr(shared_from_this()); }
+        LiteralExpr(Object obj) : Expr(LITERAL), obj(obj) {}
 };
-class GroupingExpr : public Expr, public std::enable_shared_from_this<GroupingExpr>{
+class GroupingExpr : public Expr{
     // An expression of a grouping.
     public:
-        std::shared_ptr<Expr> expr;
-        GroupingExpr(std::shared_ptr<Expr> expr) : expr(expr) {}
-        std::any accept(ExprVisitor& v) override { return v.visitGroupingExpr(shared_from_this()); }
+        Expr* expr;
+        GroupingExpr(Expr* expr) : Expr(GROUPING), expr(expr) {}
 };
-class UnaryExpr : public Expr, public std::enable_shared_from_this<UnaryExpr>{
+class UnaryExpr : public Expr{
     // An expression of a unary operation.
+    // Specialises itself when first evaluated (see Interpreter::unary).
     public:
-        Token op;
-        std::shared_ptr<Expr> expr;
-        UnaryExpr(Token op, std::shared_ptr<Expr> expr) : op(op), expr(expr) {}
-        std::any accept(ExprVisitor& v) override { return v.visitUnaryExpr(shared_from_this()); }
+        enum Specialization : std::uint8_t {
+            UNSPECIALIZED,      // not evaluated yet
+            GENERIC,            // checks the operator and the operand every time
+            NUMBER_NEGATE,      // guarded by a number operand
+            NOT                 // no guard: '!' takes any operand
+        };
+        const Token& op;
+        Expr* expr;
+        Specialization specialization = UNSPECIALIZED;
+        UnaryExpr(const Token& op, Expr* expr) : Expr(UNARY), op(op), expr(expr) {}
 };
-class BinaryExpr : public Expr, public std::enable_shared_from_this<BinaryExpr>{
+class BinaryExpr : public Expr{
     // An expression of a binary operation.
+    // Specialises itself for its operator and the types of its first operands
+    // (see Interpreter::binary). Once a guard fails, it stays GENERIC.
     public:
-        std::shared_ptr<Expr> left;
-        Token op;
-        std::shared_ptr<Expr> right;
-        BinaryExpr(std::shared_ptr<Expr> left, Token op, std::shared_ptr<Expr> right) : left(left), op(op), right(right) {}
-        std::any accept(ExprVisitor& v) override { return v.visitBinaryExpr(shared_from_this()); }
+        enum Specialization : std::uint8_t {
+            UNSPECIALIZED,      // not evaluated yet
+            GENERIC,            // checks the operator and the operands every time
+            // guarded by two number operands
+            NUMBER_ADD, NUMBER_SUBTRACT, NUMBER_MULTIPLY, NUMBER_DIVIDE,
+            NUMBER_GREATER, NUMBER_GREATER_EQUAL, NUMBER_LESS, NUMBER_LESS_EQUAL,
+            NUMBER_EQUAL, NUMBER_NOT_EQUAL,
+            // guarded by two string operands
+            STRING_CONCAT
+        };
+        Expr* left;
+        const Token& op;
+        Expr* right;
+        Specialization specialization = UNSPECIALIZED;
+        BinaryExpr(Expr* left, const Token& op, Expr* right) : Expr(BINARY), left(left), op(op), right(right) {}
 };
 
 // ---CHILD CLASSES (VARIABLES)---
-class VariableExpr : public Expr, public std::enable_shared_from_this<VariableExpr>{
+class VariableExpr : public Expr{
     // An expression of an l-value (locator value) of a variable.
     public:
-        Token name;
-        VariableExpr(Token name) :  name(name) {}
-        std::any accept(ExprVisitor& v) override { return v.visitVariableExpr(shared_from_this()); }
+        const Token& name;
+        VariableSlot slot;
+        // value of a constant global, cached on first read.
+        // valid while cacheEpoch matches Interpreter::globalEpoch
+        Object cachedGlobal;
+        unsigned cacheEpoch = 0;
+        VariableExpr(const Token& name) : Expr(VARIABLE), name(name) {}
 };
-class AssignExpr : public Expr, public std::enable_shared_from_this<AssignExpr>{
+class AssignExpr : public Expr{
     // An expression of an assignment.
     public:
-        Token name;
-        std::shared_ptr<Expr> expr;
-        AssignExpr(Token name, std::shared_ptr<Expr> expr) : name(name), expr(expr) {}
-        std::any accept(ExprVisitor& v) override { return v.visitAssignExpr(shared_from_this()); }
+        const Token& name;
+        Expr* expr;
+        VariableSlot slot;
+        AssignExpr(const Token& name, Expr* expr) : Expr(ASSIGN), name(name), expr(expr) {}
 };
-class LogicalExpr : public Expr, public std::enable_shared_from_this<LogicalExpr>{
+class LogicalExpr : public Expr{
     // An expression of a logical operator (AND, OR)
     public:
-        std::shared_ptr<Expr> left;
-        Token op;
-        std::shared_ptr<Expr> right;
-        LogicalExpr(std::shared_ptr<Expr> left, Token op, std::shared_ptr<Expr> right):
-            left(left), op(op), right(right) {}
-        std::any accept(ExprVisitor& v) override { return v.visitLogicalExpr(shared_from_this()); }
+        Expr* left;
+        const Token& op;
+        Expr* right;
+        LogicalExpr(Expr* left, const Token& op, Expr* right) :
+            Expr(LOGICAL), left(left), op(op), right(right) {}
 };
 
 // ---CHILD CLASSES (FUNCTIONS, CLASSES AND METHODS)---
-class CallExpr : public Expr, public std::enable_shared_from_this<CallExpr>{
+class CallExpr : public Expr{
     // An expression for a call by a callable.
     public:
-        std::shared_ptr<Expr> callee;
-        Token paren;
-        std::vector<std::shared_ptr<Expr>> arguments;
-        CallExpr(std::shared_ptr<Expr> callee, Token paren, std::vector<std::shared_ptr<Expr>> arguments) :
-            callee(callee), paren(paren), arguments(arguments) {}
-        std::any accept(ExprVisitor& v) override { return v.visitCallExpr(shared_from_this()); }
-};
-class GetExpr : public Expr, public std::enable_shared_from_this<GetExpr>{
+        Expr* callee;
+        const Token& paren;
+        std::vector<Expr*> arguments;
+        CallCache cache;
+        CallExpr(Expr* callee, const Token& paren, std::vector<Expr*> arguments) :
+            Expr(CALL), callee(callee), paren(paren), arguments(arguments) {}
+};
+class GetExpr : public Expr{
     // An expression to get property [name] from LoxInstance [expr]
     public:
-        std::shared_ptr<Expr> expr;
-        Token name;
-        GetExpr(std::shared_ptr<Expr> expr, Token name) : expr(expr), name(name) {}
-        std::any accept(ExprVisitor& v) override { return v.visitGetExpr(shared_from_this()); }
+        Expr* expr;
+        const Token& name;
+        PropertyCache cache;
+        GetExpr(Expr* expr, const Token& name) : Expr(GET), expr(expr), name(name) {}
 };
-class SetExpr : public Expr, public std::enable_shared_from_this<SetExpr>{
+class SetExpr : public Expr{
     // An expression to set property [name] from LoxInstance [expr] to [value]
     public:
-        std::shared_ptr<Expr> expr;
-        Token name;
-        std::shared_ptr<Expr> value;
-        SetExpr(std::shared_ptr<Expr> expr, Token name, std::shared_ptr<Expr> value) : expr(expr), name(name), value(value) {}
-        std::any accept(ExprVisitor& v) override { return v.visitSetExpr(shared_from_this()); }
+        Expr* expr;
+        const Token& name;
+        Expr* value;
+        PropertyCache cache;
+        SetExpr(Expr* expr, const Token& name, Expr* value) : Expr(SET), expr(expr), name(name), value(value) {}
 };
-class ThisExpr : public Expr, public std::enable_shared_from_this<ThisExpr>{
+class ThisExpr : public Expr{
     // An expression for 'this' keyword
     public:
-        Token keyword;
-        ThisExpr(Token keyword) : keyword(keyword) {}
-        std::any accept(ExprVisitor& v) override { return v.visitThisExpr(shared_from_this()); }
+        const Token& keyword;
+        VariableSlot slot;
+        ThisExpr(const Token& keyword) : Expr(THIS), keyword(keyword) {}
 };
-class SuperExpr : public Expr, public std::enable_shared_from_this<SuperExpr>{
+class SuperExpr : public Expr{
     // An expression for 'super' keyword followed by method access
     public:
-        Token keyword;
-        Token method;
-        SuperExpr(Token keyword, Token method) : keyword(keyword), method(method) {}
-        std::any accept(ExprVisitor& v) override { return v.visitSuperExpr(shared_from_this()); }
-};
\ No newline at end of file
+        const Token& keyword;
+        const Token& method;
+        VariableSlot slot;        // 'super' (the superclass)
+        VariableSlot thisSlot;    // 'this' (the receiver)
+        SuperExpr(const Token& keyword, const Token& method) : Expr(SUPER), keyword(keyword), method(method) {}
+};
+
+
+template<typename R>
+R ExprVisitor<R>::visit(Expr* curr){
+    // dispatches on the type of [curr], without a virtual accept() or a type-erased result
+    switch (curr->type){
+        case Expr::LITERAL: return visitLiteralExpr(static_cast<LiteralExpr*>(curr));
+        case Expr::GROUPING: return visitGroupingExpr(static_cast<GroupingExpr*>(curr));
+        case Expr::UNARY: return visitUnaryExpr(static_cast<UnaryExpr*>(curr));
+        case Expr::BINARY: return visitBinaryExpr(static_cast<BinaryExpr*>(curr));
+        case Expr::VARIABLE: return visitVariableExpr(static_cast<VariableExpr*>(curr));
+        case Expr::ASSIGN: return visitAssignExpr(static_cast<AssignExpr*>(curr));
+        case Expr::LOGICAL: return visitLogicalExpr(static_cast<LogicalExpr*>(curr));
+        case Expr::CALL: return visitCallExpr(static_cast<CallExpr*>(curr));
+        case Expr::GET: return visitGetExpr(static_cast<GetExpr*>(curr));
+        case Expr::SET: return visitSetExpr(static_cast<SetExpr*>(curr));
+        case Expr::THIS: return visitThisExpr(static_cast<ThisExpr*>(curr));
+        default: return visitSuperExpr(static_cast<SuperExpr*>(curr));
+    }
+}
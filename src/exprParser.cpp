@@ -4,16 +4,16 @@ bool ExprParser::isAtEnd(){
     return tokens.at(curr).type == Token::_EOF;
 }
 
-Token ExprParser::advance(){
+const Token& ExprParser::advance(){
     if (!isAtEnd()) curr++;
     return previous();
 }
 
-Token ExprParser::peek(){
+const Token& ExprParser::peek(){
     return tokens.at(curr);
 }
 
-Token ExprParser::previous(){
+const Token& ExprParser::previous(){
     return tokens.at(curr - 1);
 }
 
@@ -22,27 +22,15 @@ bool ExprParser::check(Token::TokenType t){
     return peek().type == t;
 }
 
-template<typename... Args>
-bool ExprParser::match(Args... args){
-    // check if any of the TokenTypes given matches the current token
-    // if yes, advance and return true
-    for (const Token::TokenType t : {args...}){
-        if (peek().type == t){
-            advance();
-            return true;
-        }
-    }
-    return false;
-}
 
-Token ExprParser::consume(Token::TokenType t, std::string err){
+const Token& ExprParser::consume(Token::TokenType t, std::string err){
     // consumes current token of TokenType t
     // if current token is not t, throw an error
     if (check(t)) return advance();
     throw(error(peek(), err));
 }
 
-LoxError::ParseError ExprParser::error(Token token, std::string err){
+LoxError::ParseError ExprParser::error(const Token& token, std::string err){
     hasError = true;
     return LoxError::ParseError(token, err);
 }
@@ -67,7 +55,7 @@ void ExprParser::synchronize(){
 }
 
 
-std::shared_ptr<Expr> ExprParser::parse(bool silenced){
+Expr* ExprParser::parse(bool silenced){
     hasError = false;
     curr = 0;
     try{
@@ -97,114 +85,114 @@ primary        → NUMBER | STRING | "true" | "false" | "nil"
                | "(" expression ")" | IDENTIFIER ;
 */
 
-std::shared_ptr<Expr> ExprParser::expression(){
+Expr* ExprParser::expression(){
     return assignment();
 }
 
-std::shared_ptr<Expr> ExprParser::assignment(){
-    std::shared_ptr<Expr> expr = logicOr();
+Expr* ExprParser::assignment(){
+    Expr* expr = logicOr();
     // if the next token is EQUAL, parse as assignment
     // (expr must be a variable l-value)
     // otherwise, parse (beforehand) and return as equality
     if (match(Token::EQUAL)){
-        Token op = previous();
-        std::shared_ptr<Expr> value = assignment();
-        if (VariableExpr* e = dynamic_cast<VariableExpr*>(expr.get())){
-            Token name = e->name;
-            return std::make_shared<AssignExpr>(name, value);
+        const Token& op = previous();
+        Expr* value = assignment();
+        if (VariableExpr* e = dynamic_cast<VariableExpr*>(expr)){
+            const Token& name = e->name;
+            return arena.make<AssignExpr>(name, value);
         }
-        else if (GetExpr* e = dynamic_cast<GetExpr*>(expr.get())){
-            return std::make_shared<SetExpr>(e->expr, e->name, value);
+        else if (GetExpr* e = dynamic_cast<GetExpr*>(expr)){
+            return arena.make<SetExpr>(e->expr, e->name, value);
         }
         else throw error(op, "Invalid assignment target.");
     }
     else return expr;
 }
 
-std::shared_ptr<Expr> ExprParser::logicOr(){
-    std::shared_ptr<Expr> expr = logicAnd();
+Expr* ExprParser::logicOr(){
+    Expr* expr = logicAnd();
     while (match(Token::OR)){
-        Token op = previous();
-        std::shared_ptr<Expr> right = logicAnd();
-        expr = std::make_shared<LogicalExpr>(expr, op, right);
+        const Token& op = previous();
+        Expr* right = logicAnd();
+        expr = arena.make<LogicalExpr>(expr, op, right);
     }
     return expr;
 }
-std::shared_ptr<Expr> ExprParser::logicAnd(){
-    std::shared_ptr<Expr> expr = equality();
+Expr* ExprParser::logicAnd(){
+    Expr* expr = equality();
     while (match(Token::AND)){
-        Token op = previous();
-        std::shared_ptr<Expr> right = equality();
-        expr = std::make_shared<LogicalExpr>(expr, op, right);
+        const Token& op = previous();
+        Expr* right = equality();
+        expr = arena.make<LogicalExpr>(expr, op, right);
     }
     return expr;
 }
 
-std::shared_ptr<Expr> ExprParser::equality(){
-    std::shared_ptr<Expr> expr = comparison();
+Expr* ExprParser::equality(){
+    Expr* expr = comparison();
     while (match(Token::BANG_EQUAL, Token::EQUAL_EQUAL)){
-        Token op = previous();
-        std::shared_ptr<Expr> right = comparison();
-        expr = std::make_shared<BinaryExpr>(expr, op, right);
+        const Token& op = previous();
+        Expr* right = comparison();
+        expr = arena.make<BinaryExpr>(expr, op, right);
     }
     return expr;
 }
 
-std::shared_ptr<Expr> ExprParser::comparison(){
-    std::shared_ptr<Expr> expr = term();
+Expr* ExprParser::comparison(){
+    Expr* expr = term();
     while (match(Token::GREATER, Token::GREATER_EQUAL, Token::LESS, Token::LESS_EQUAL)){
-        Token op = previous();
-        std::shared_ptr<Expr> right = term();
-        expr = std::make_shared<BinaryExpr>(expr, op, right);
+        const Token& op = previous();
+        Expr* right = term();
+        expr = arena.make<BinaryExpr>(expr, op, right);
     }
     return expr;
 }
 
-std::shared_ptr<Expr> ExprParser::term(){
-    std::shared_ptr<Expr> expr = factor();
+Expr* ExprParser::term(){
+    Expr* expr = factor();
     while (match(Token::MINUS, Token::PLUS)){
-        Token op = previous();
-        std::shared_ptr<Expr> right = factor();
-        expr = std::make_shared<BinaryExpr>(expr, op, right);
+        const Token& op = previous();
+        Expr* right = factor();
+        expr = arena.make<BinaryExpr>(expr, op, right);
     }
     return expr;
 }
 
-std::shared_ptr<Expr> ExprParser::factor(){
-    std::shared_ptr<Expr> expr = unary();
+Expr* ExprParser::factor(){
+    Expr* expr = unary();
     while (match(Token::STAR, Token::SLASH)){
-        Token op = previous();
-        std::shared_ptr<Expr> right = unary();
-        expr = std::make_shared<BinaryExpr>(expr, op, right);
+        const Token& op = previous();
+        Expr* right = unary();
+        expr = arena.make<BinaryExpr>(expr, op, right);
     }
     return expr;
 }
 
-std::shared_ptr<Expr> ExprParser::unary(){
+Expr* ExprParser::unary(){
     if (match(Token::BANG, Token::MINUS)){
-        Token op = previous();
-        std::shared_ptr<Expr> expr = unary();
-        return std::make_shared<UnaryExpr>(op, expr);
+        const Token& op = previous();
+        Expr* expr = unary();
+        return arena.make<UnaryExpr>(op, expr);
     }
     return call();
 }
 
-std::shared_ptr<Expr> ExprParser::call(){
-    std::shared_ptr<Expr> expr = primary();
+Expr* ExprParser::call(){
+    Expr* expr = primary();
     while (true){
         if (match(Token::LEFT_PAREN)){
             expr = finishCall(expr);
         }
         else if (match(Token::DOT)){
-            Token name = consume(Token::IDENTIFIER, "Expect property name after '.'");
-            expr = std::make_shared<GetExpr>(expr, name);
+            const Token& name = consume(Token::IDENTIFIER, "Expect property name after '.'");
+            expr = arena.make<GetExpr>(expr, name);
         }
         else break;
     }
     return expr;
 }
-std::shared_ptr<Expr> ExprParser::finishCall(std::shared_ptr<Expr> callee){
-    std::vector<std::shared_ptr<Expr>> arguments = {};
+Expr* ExprParser::finishCall(Expr* callee){
+    std::vector<Expr*> arguments = {};
     if (!check(Token::RIGHT_PAREN)){
         do{
             if (arguments.size() >= 255)
@@ -212,38 +200,38 @@ std::shared_ptr<Expr> ExprParser::finishCall(std::shared_ptr<Expr> callee){
             arguments.push_back(expression());
         } while (match(Token::COMMA));
     }
-    Token paren = consume(Token::RIGHT_PAREN, "Expect ')' after arguments.");
-    return std::make_shared<CallExpr>(callee, paren, arguments);
+    const Token& paren = consume(Token::RIGHT_PAREN, "Expect ')' after arguments.");
+    return arena.make<CallExpr>(callee, paren, arguments);
 }
 
-std::shared_ptr<Expr> ExprParser::primary(){
+Expr* ExprParser::primary(){
     // true, false, nil literals
-    if (match(Token::TRUE)) return std::make_shared<LiteralExpr>(Object::boolean(1));
-    if (match(Token::FALSE)) return std::make_shared<LiteralExpr>(Object::boolean(0));
-    if (match(Token::NIL)) return std::make_shared<LiteralExpr>(Object::nil());
+    if (match(Token::TRUE)) return arena.make<LiteralExpr>(Object::boolean(1));
+    if (match(Token::FALSE)) return arena.make<LiteralExpr>(Object::boolean(0));
+    if (match(Token::NIL)) return arena.make<LiteralExpr>(Object::nil());
 
     // number and string literals
     if (match(Token::NUMBER, Token::STRING)) 
-        return std::make_shared<LiteralExpr>(previous().literal);
+        return arena.make<LiteralExpr>(previous().literal);
     
     // grouping (parenthesis pair)
     if (match(Token::LEFT_PAREN)){
-        std::shared_ptr<Expr> expr = expression();
+        Expr* expr = expression();
         consume(Token::RIGHT_PAREN, "Expect ) after expression.");
-        return std::make_shared<GroupingExpr>(expr);
+        return arena.make<GroupingExpr>(expr);
     }
 
     // identifiers (super, this, generic identifiers)
     if (match(Token::SUPER)){
-        Token keyword = previous();
+        const Token& keyword = previous();
         consume(Token::DOT, "Expect '.' after 'super'.");
-        Token method = consume(Token::IDENTIFIER, "Expect superclass method name.");
-        return std::make_shared<SuperExpr>(keyword, method);
+        const Token& method = consume(Token::IDENTIFIER, "Expect superclass method name.");
+        return arena.make<SuperExpr>(keyword, method);
     }
     if (match(Token::THIS))
-        return std::make_shared<ThisExpr>(previous());
+        return arena.make<ThisExpr>(previous());
     if (match(Token::IDENTIFIER))
-        return std::make_shared<VariableExpr>(previous());
+        return arena.make<VariableExpr>(previous());
 
     // at end of file. return
     if (isAtEnd()) return nullptr;
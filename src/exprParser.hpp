@@ -3,9 +3,10 @@
 // allows variadic functions
 #include <cstdarg>
 
-// requires expressions, ability to throw errors
+// requires expressions, ability to throw errors, and an arena to allocate nodes in
 #include "expr.hpp"
 #include "loxOutput.hpp"
+#include "astArena.hpp"
 
 #pragma once
 
@@ -28,42 +29,54 @@ primary        → NUMBER | STRING | "true" | "false" | "nil"
 
 class ExprParser{
     // Converts a vector of Tokens to an AST
+    // Nodes are allocated in, and the tokens are owned by, the given AstArena
     public:
         bool hasError = false;
-        ExprParser(std::vector<Token> tokens) : tokens(tokens) {}
+        ExprParser(AstArena& arena) : arena(arena), tokens(arena.tokens) {}
         // added silenced flag to suppress errors for StmtParser::parse
-        std::shared_ptr<Expr> parse(bool silenced = false);
+        Expr* parse(bool silenced = false);
 
     protected:
-        std::vector<Token> tokens;
+        AstArena& arena;
+        const std::vector<Token>& tokens;
         int curr = 0;
 
         // Helper functions for parsing
         bool isAtEnd(void);
-        Token advance(void);
-        Token peek(void);
-        Token previous(void);
+        const Token& advance(void);
+        const Token& peek(void);
+        const Token& previous(void);
         bool check(Token::TokenType t);
         template<typename... Args>
-        bool match(Args... t);
-        Token consume(Token::TokenType t, std::string err);
+        bool match(Args... args){
+            // check if any of the TokenTypes given matches the current token
+            // if yes, advance and return true
+            for (const Token::TokenType t : {args...}){
+                if (peek().type == t){
+                    advance();
+                    return true;
+                }
+            }
+            return false;
+        }
+        const Token& consume(Token::TokenType t, std::string err);
 
         // Error handlinng and synchronization
-        LoxError::ParseError error(Token token, std::string err);
+        LoxError::ParseError error(const Token& token, std::string err);
         void synchronize(void);
 
         // Expression parsing
-        std::shared_ptr<Expr> expression();
-        std::shared_ptr<Expr> assignment();
-        std::shared_ptr<Expr> logicOr();
-        std::shared_ptr<Expr> logicAnd();
-        std::shared_ptr<Expr> equality();
-        std::shared_ptr<Expr> comparison();
-        std::shared_ptr<Expr> term();
-        std::shared_ptr<Expr> factor();
-        std::shared_ptr<Expr> unary();
-        std::shared_ptr<Expr> call();
-        std::shared_ptr<Expr> primary();
+        Expr* expression();
+        Expr* assignment();
+        Expr* logicOr();
+        Expr* logicAnd();
+        Expr* equality();
+        Expr* comparison();
+        Expr* term();
+        Expr* factor();
+        Expr* unary();
+        Expr* call();
+        Expr* primary();
 
-        std::shared_ptr<Expr> finishCall(std::shared_ptr<Expr> callee);
+        Expr* finishCall(Expr* callee);
 };
\ No newline at end of file
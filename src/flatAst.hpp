@@ -0,0 +1,92 @@
+// requires expressions and statements, which nodes refer to for declarations and errors
+#include "expr.hpp"
+#include "stmt.hpp"
+
+// required for the columns
+#include <cstdint>
+#include <vector>
+
+#pragma once
+
+class FlatAst{
+    // A lowered AST, stored as a struct of arrays: node [n] is kinds[n] with operands
+    // a[n], b[n] and c[n]. Children are referred to by 32-bit index, and everything that
+    // is not a child (literals, source tokens, lists, declarations) lives in a side table.
+    // Built by FlatCompiler, evaluated by FlatInterpreter.
+    /*
+        KEY NOTES:
+        1. Operands, by kind (children unless stated otherwise; NONE if absent):
+             LITERAL                        a: literals
+             LOCAL, BOXED, UPVALUE          a: slot
+             GLOBAL                         a: exprs (VariableExpr)
+             ASSIGN_LOCAL/BOXED/UPVALUE     a: slot,  b: value
+             ASSIGN_GLOBAL                  a: value, b: exprs (AssignExpr)
+             NEGATE, NOT                    a: operand, b: sources (the operator)
+             ADD ... NOT_EQUAL              a: left, b: right, c: sources (the operator)
+             AND, OR                        a: left, b: right
+             CALL                           a: callee, b: lists (arguments), c: exprs (CallExpr)
+             INVOKE                         a: object, b: lists (arguments), c: exprs (CallExpr),
+                                            for 'object.name(...)': calls the method unbound
+             GET                            a: object, b: exprs (GetExpr)
+             SET                            a: object, b: value, c: exprs (SetExpr)
+             SUPER                          a: exprs (SuperExpr)
+             EXPRESSION, PRINT              a: expression
+             DEFINE_LOCAL                   a: slot,  b: initializer
+             DEFINE                         a: stmts (VarStmt), b: initializer
+             BLOCK                          a: lists (statements)
+             IF                             a: condition, b: then, c: else
+             WHILE                          a: condition, b: body
+             FUNCTION, CLASS                a: stmts (the declaration, run by the Interpreter)
+             RETURN                         a: value
+             TAIL_CALL                      as CALL, for 'return f(...)'
+             TAIL_INVOKE                    as INVOKE, for 'return object.name(...)'
+        2. A list in [lists] is its length followed by its items.
+        3. The bodies of functions and methods are BLOCKs of the same FlatAst.
+    */
+    public:
+        enum Kind : std::uint8_t {
+            // expressions
+            LITERAL,
+            LOCAL, BOXED, UPVALUE, GLOBAL,
+            ASSIGN_LOCAL, ASSIGN_BOXED, ASSIGN_UPVALUE, ASSIGN_GLOBAL,
+            NEGATE, NOT,
+            ADD, SUBTRACT, MULTIPLY, DIVIDE,
+            GREATER, GREATER_EQUAL, LESS, LESS_EQUAL, EQUAL, NOT_EQUAL,
+            AND, OR,
+            CALL, INVOKE, GET, SET, SUPER,
+            // statements
+            EXPRESSION, PRINT, DEFINE_LOCAL, DEFINE, BLOCK,
+            IF, WHILE,
+            FUNCTION, CLASS, RETURN, TAIL_CALL, TAIL_INVOKE
+        };
+        static constexpr std::uint32_t NONE = UINT32_MAX;
+
+        // columns, one entry per node
+        std::vector<Kind> kinds = {};
+        std::vector<std::uint32_t> a = {};
+        std::vector<std::uint32_t> b = {};
+        std::vector<std::uint32_t> c = {};
+
+        // side tables
+        std::vector<Object> literals = {};
+        std::vector<const Token*> sources = {};    // source location (line and lexeme) of errors
+        std::vector<std::uint32_t> lists = {};
+        std::vector<Expr*> exprs = {};
+        std::vector<Stmt*> stmts = {};
+
+        std::uint32_t add(Kind kind, std::uint32_t a = NONE, std::uint32_t b = NONE, std::uint32_t c = NONE){
+            kinds.push_back(kind);
+            this->a.push_back(a);
+            this->b.push_back(b);
+            this->c.push_back(c);
+            return (std::uint32_t)kinds.size() - 1;
+        }
+        size_t nodes(void) const { return kinds.size(); }
+        size_t bytesUsed(void) const {
+            // memory of the columns and side tables (excluding unused capacity)
+            return kinds.size() * (sizeof(Kind) + 3 * sizeof(std::uint32_t))
+                + literals.size() * sizeof(Object) + sources.size() * sizeof(const Token*)
+                + lists.size() * sizeof(std::uint32_t)
+                + exprs.size() * sizeof(Expr*) + stmts.size() * sizeof(Stmt*);
+        }
+};
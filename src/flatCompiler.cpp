@@ -0,0 +1,173 @@
+#include "flatCompiler.hpp"
+
+StmtCode* FlatCompiler::compile(std::vector<Stmt*>& statements){
+    // lowers a program into a new FlatAst. returns the code running it
+    ast = arena.make<FlatAst>();
+    const std::uint32_t root = block(statements);
+    return arena.make<FlatCode>(ast, root);
+}
+void FlatCompiler::compileBody(FunctionStmt* function){
+    function->code = arena.make<FlatCode>(ast, block(function->body));
+}
+
+std::uint32_t FlatCompiler::block(std::vector<Stmt*>& statements){
+    std::vector<std::uint32_t> items = {};
+    items.reserve(statements.size());
+    for (Stmt* statement : statements) items.push_back(visit(statement));
+    return ast->add(FlatAst::BLOCK, list(std::move(items)));
+}
+std::uint32_t FlatCompiler::list(std::vector<std::uint32_t> items){
+    // appends a list (its length, then its items) to the side table
+    const std::uint32_t start = (std::uint32_t)ast->lists.size();
+    ast->lists.push_back((std::uint32_t)items.size());
+    ast->lists.insert(ast->lists.end(), items.begin(), items.end());
+    return start;
+}
+std::uint32_t FlatCompiler::variable(const VariableSlot& slot, Expr* curr){
+    // reads a variable, wherever the Resolver placed it
+    switch (slot.kind){
+        case VariableSlot::LOCAL: return ast->add(FlatAst::LOCAL, slot.index);
+        case VariableSlot::BOXED: return ast->add(FlatAst::BOXED, slot.index);
+        case VariableSlot::UPVALUE: return ast->add(FlatAst::UPVALUE, slot.index);
+        default: return ast->add(FlatAst::GLOBAL, expr(curr));
+    }
+}
+std::uint32_t FlatCompiler::call(FlatAst::Kind kind, CallExpr* curr){
+    if (curr->callee->type == Expr::GET){
+        // a method call: INVOKE (or TAIL_INVOKE) evaluates the object, not the bound method
+        const std::uint32_t obj = visit(static_cast<GetExpr*>(curr->callee)->expr);
+        std::vector<std::uint32_t> arguments = {};
+        for (Expr* argument : curr->arguments) arguments.push_back(visit(argument));
+        kind = kind == FlatAst::CALL ? FlatAst::INVOKE : FlatAst::TAIL_INVOKE;
+        return ast->add(kind, obj, list(std::move(arguments)), expr(curr));
+    }
+    const std::uint32_t callee = visit(curr->callee);
+    std::vector<std::uint32_t> arguments = {};
+    for (Expr* argument : curr->arguments) arguments.push_back(visit(argument));
+    return ast->add(kind, callee, list(std::move(arguments)), expr(curr));
+}
+
+std::uint32_t FlatCompiler::source(const Token& token){
+    ast->sources.push_back(&token);
+    return (std::uint32_t)ast->sources.size() - 1;
+}
+std::uint32_t FlatCompiler::expr(Expr* curr){
+    ast->exprs.push_back(curr);
+    return (std::uint32_t)ast->exprs.size() - 1;
+}
+std::uint32_t FlatCompiler::stmt(Stmt* curr){
+    ast->stmts.push_back(curr);
+    return (std::uint32_t)ast->stmts.size() - 1;
+}
+
+
+// ---EXPR CHILD CLASSES---
+std::uint32_t FlatCompiler::visitLiteralExpr(LiteralExpr* curr){
+    ast->literals.push_back(curr->obj);
+    return ast->add(FlatAst::LITERAL, (std::uint32_t)ast->literals.size() - 1);
+}
+std::uint32_t FlatCompiler::visitGroupingExpr(GroupingExpr* curr){
+    return visit(curr->expr);
+}
+std::uint32_t FlatCompiler::visitUnaryExpr(UnaryExpr* curr){
+    const std::uint32_t operand = visit(curr->expr);
+    if (curr->op.type == Token::BANG) return ast->add(FlatAst::NOT, operand);
+    return ast->add(FlatAst::NEGATE, operand, source(curr->op));
+}
+std::uint32_t FlatCompiler::visitBinaryExpr(BinaryExpr* curr){
+    const std::uint32_t left = visit(curr->left);
+    const std::uint32_t right = visit(curr->right);
+    FlatAst::Kind kind;
+    switch (curr->op.type){
+        case Token::PLUS: kind = FlatAst::ADD; break;
+        case Token::MINUS: kind = FlatAst::SUBTRACT; break;
+        case Token::STAR: kind = FlatAst::MULTIPLY; break;
+        case Token::SLASH: kind = FlatAst::DIVIDE; break;
+        case Token::GREATER: kind = FlatAst::GREATER; break;
+        case Token::GREATER_EQUAL: kind = FlatAst::GREATER_EQUAL; break;
+        case Token::LESS: kind = FlatAst::LESS; break;
+        case Token::LESS_EQUAL: kind = FlatAst::LESS_EQUAL; break;
+        case Token::EQUAL_EQUAL: return ast->add(FlatAst::EQUAL, left, right);
+        default: return ast->add(FlatAst::NOT_EQUAL, left, right);
+    }
+    return ast->add(kind, left, right, source(curr->op));
+}
+
+std::uint32_t FlatCompiler::visitVariableExpr(VariableExpr* curr){
+    return variable(curr->slot, curr);
+}
+std::uint32_t FlatCompiler::visitAssignExpr(AssignExpr* curr){
+    const std::uint32_t value = visit(curr->expr);
+    switch (curr->slot.kind){
+        case VariableSlot::LOCAL: return ast->add(FlatAst::ASSIGN_LOCAL, curr->slot.index, value);
+        case VariableSlot::BOXED: return ast->add(FlatAst::ASSIGN_BOXED, curr->slot.index, value);
+        case VariableSlot::UPVALUE: return ast->add(FlatAst::ASSIGN_UPVALUE, curr->slot.index, value);
+        default: return ast->add(FlatAst::ASSIGN_GLOBAL, value, expr(curr));
+    }
+}
+std::uint32_t FlatCompiler::visitLogicalExpr(LogicalExpr* curr){
+    const std::uint32_t left = visit(curr->left);
+    const std::uint32_t right = visit(curr->right);
+    return ast->add(curr->op.type == Token::OR ? FlatAst::OR : FlatAst::AND, left, right);
+}
+
+std::uint32_t FlatCompiler::visitCallExpr(CallExpr* curr){
+    return call(FlatAst::CALL, curr);
+}
+std::uint32_t FlatCompiler::visitGetExpr(GetExpr* curr){
+    const std::uint32_t obj = visit(curr->expr);
+    return ast->add(FlatAst::GET, obj, expr(curr));
+}
+std::uint32_t FlatCompiler::visitSetExpr(SetExpr* curr){
+    const std::uint32_t obj = visit(curr->expr);
+    const std::uint32_t value = visit(curr->value);
+    return ast->add(FlatAst::SET, obj, value, expr(curr));
+}
+std::uint32_t FlatCompiler::visitThisExpr(ThisExpr* curr){
+    return variable(curr->slot, curr);
+}
+std::uint32_t FlatCompiler::visitSuperExpr(SuperExpr* curr){
+    return ast->add(FlatAst::SUPER, expr(curr));
+}
+
+
+// ---STMT CHILD CLASSES---
+std::uint32_t FlatCompiler::visitExpressionStmt(ExpressionStmt* curr){
+    return ast->add(FlatAst::EXPRESSION, visit(curr->expr));
+}
+std::uint32_t FlatCompiler::visitPrintStmt(PrintStmt* curr){
+    return ast->add(FlatAst::PRINT, visit(curr->expr));
+}
+std::uint32_t FlatCompiler::visitVarStmt(VarStmt* curr){
+    const std::uint32_t initializer = curr->initializer ? visit(curr->initializer) : FlatAst::NONE;
+    if (curr->slot.kind == VariableSlot::LOCAL) return ast->add(FlatAst::DEFINE_LOCAL, curr->slot.index, initializer);
+    return ast->add(FlatAst::DEFINE, stmt(curr), initializer);
+}
+std::uint32_t FlatCompiler::visitBlockStmt(BlockStmt* curr){
+    return block(curr->statements);
+}
+
+std::uint32_t FlatCompiler::visitIfStmt(IfStmt* curr){
+    const std::uint32_t condition = visit(curr->condition);
+    const std::uint32_t thenBranch = visit(curr->thenBranch);
+    const std::uint32_t elseBranch = curr->elseBranch ? visit(curr->elseBranch) : FlatAst::NONE;
+    return ast->add(FlatAst::IF, condition, thenBranch, elseBranch);
+}
+std::uint32_t FlatCompiler::visitWhileStmt(WhileStmt* curr){
+    const std::uint32_t condition = visit(curr->condition);
+    const std::uint32_t body = visit(curr->body);
+    return ast->add(FlatAst::WHILE, condition, body);
+}
+
+std::uint32_t FlatCompiler::visitFunctionStmt(FunctionStmt* curr){
+    compileBody(curr);
+    return ast->add(FlatAst::FUNCTION, stmt(curr));
+}
+std::uint32_t FlatCompiler::visitReturnStmt(ReturnStmt* curr){
+    if (curr->tailCall) return call(FlatAst::TAIL_CALL, curr->tailCall);
+    return ast->add(FlatAst::RETURN, curr->expr ? visit(curr->expr) : FlatAst::NONE);
+}
+std::uint32_t FlatCompiler::visitClassStmt(ClassStmt* curr){
+    for (FunctionStmt* method : curr->methods) compileBody(method);
+    return ast->add(FlatAst::CLASS, stmt(curr));
+}
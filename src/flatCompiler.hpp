@@ -0,0 +1,68 @@
+// requires the lowered AST, and FlatCode to run it
+#include "flatAst.hpp"
+#include "flatInterpreter.hpp"
+// the lowered AST is allocated with the AST it was lowered from
+#include "astArena.hpp"
+
+#pragma once
+
+class FlatCompiler : public ExprVisitor<std::uint32_t>, public StmtVisitor<std::uint32_t>{
+    // Lowers a resolved AST into a FlatAst, via the Visitor design pattern.
+    // Each visit appends the node (after its children) and returns its index.
+    /*
+        KEY NOTES:
+        1. One FlatAst per program, allocated in the arena of the AST: the bodies of functions
+           and methods are lowered into it, and run through FunctionStmt::code.
+        2. Groupings disappear; operators, slot kinds and 'this' become kinds of node.
+        3. Declarations (functions, classes, globals) keep pointing at their AST nodes,
+           which the Interpreter runs them from.
+    */
+    public:
+        FlatCompiler(AstArena& arena) : arena(arena) {}
+        using ExprVisitor<std::uint32_t>::visit;
+        using StmtVisitor<std::uint32_t>::visit;
+        StmtCode* compile(std::vector<Stmt*>& statements);
+
+        // EXPR CHILD CLASSES
+        std::uint32_t visitLiteralExpr(LiteralExpr* curr) override;
+        std::uint32_t visitGroupingExpr(GroupingExpr* curr) override;
+        std::uint32_t visitUnaryExpr(UnaryExpr* curr) override;
+        std::uint32_t visitBinaryExpr(BinaryExpr* curr) override;
+
+        std::uint32_t visitVariableExpr(VariableExpr* curr) override;
+        std::uint32_t visitAssignExpr(AssignExpr* curr) override;
+        std::uint32_t visitLogicalExpr(LogicalExpr* curr) override;
+
+        std::uint32_t visitCallExpr(CallExpr* curr) override;
+        std::uint32_t visitGetExpr(GetExpr* curr) override;
+        std::uint32_t visitSetExpr(SetExpr* curr) override;
+        std::uint32_t visitThisExpr(ThisExpr* curr) override;
+        std::uint32_t visitSuperExpr(SuperExpr* curr) override;
+
+        // STMT CHILD CLASSES
+        std::uint32_t visitExpressionStmt(ExpressionStmt* curr) override;
+        std::uint32_t visitPrintStmt(PrintStmt* curr) override;
+        std::uint32_t visitVarStmt(VarStmt* curr) override;
+        std::uint32_t visitBlockStmt(BlockStmt* curr) override;
+
+        std::uint32_t visitIfStmt(IfStmt* curr) override;
+        std::uint32_t visitWhileStmt(WhileStmt* curr) override;
+
+        std::uint32_t visitFunctionStmt(FunctionStmt* curr) override;
+        std::uint32_t visitReturnStmt(ReturnStmt* curr) override;
+        std::uint32_t visitClassStmt(ClassStmt* curr) override;
+
+    private:
+        AstArena& arena;
+        FlatAst* ast = nullptr;
+
+        std::uint32_t block(std::vector<Stmt*>& statements);
+        std::uint32_t list(std::vector<std::uint32_t> items);
+        std::uint32_t variable(const VariableSlot& slot, Expr* curr);
+        std::uint32_t call(FlatAst::Kind kind, CallExpr* curr);
+        void compileBody(FunctionStmt* function);
+
+        std::uint32_t source(const Token& token);
+        std::uint32_t expr(Expr* curr);
+        std::uint32_t stmt(Stmt* curr);
+};
@@ -0,0 +1,202 @@
+#include "flatInterpreter.hpp"
+
+Object FlatInterpreter::evaluate(std::uint32_t node){
+    const std::uint32_t a = ast.a[node];
+    const std::uint32_t b = ast.b[node];
+    switch (ast.kinds[node]){
+        case FlatAst::LITERAL:
+            return ast.literals[a];
+
+        // variables
+        case FlatAst::LOCAL:
+            return local(a);
+        case FlatAst::BOXED:
+            return local(a).as<LoxUpvalue>()->value;
+        case FlatAst::UPVALUE:
+            return interpreter.closure->upvalues[a]->value;
+        case FlatAst::GLOBAL:
+            return interpreter.globalVariable(static_cast<VariableExpr*>(ast.exprs[a]));
+        // the value is evaluated first: it may grow the stack
+        case FlatAst::ASSIGN_LOCAL:{
+            Object value = evaluate(b);
+            local(a) = value;
+            return value;
+        }
+        case FlatAst::ASSIGN_BOXED:{
+            Object value = evaluate(b);
+            local(a).as<LoxUpvalue>()->value = value;
+            return value;
+        }
+        case FlatAst::ASSIGN_UPVALUE:{
+            Object value = evaluate(b);
+            interpreter.closure->upvalues[a]->value = value;
+            return value;
+        }
+        case FlatAst::ASSIGN_GLOBAL:{
+            Object value = evaluate(a);
+            interpreter.assign(static_cast<AssignExpr*>(ast.exprs[b]), value);
+            return value;
+        }
+
+        // operators. numbers take the fast path;
+        // everything else (string concatenation, type errors) is left to Interpreter::binary
+        case FlatAst::NEGATE:{
+            Object operand = evaluate(a);
+            if (operand.type == Object::NUMBER) return Object::number(-operand.literalNumber);
+            return interpreter.unary(*ast.sources[b], operand);
+        }
+        case FlatAst::NOT:
+            return Object::boolean(!interpreter.isTruthy(evaluate(a)));
+        #define FLAT_BINARY(kind, result)                                                   \
+            case FlatAst::kind:{                                                            \
+                Object left = evaluate(a);                                                  \
+                Object right = evaluate(b);                                                 \
+                if (left.type == Object::NUMBER && right.type == Object::NUMBER){           \
+                    const double x = left.literalNumber, y = right.literalNumber;           \
+                    return result;                                                          \
+                }                                                                           \
+                return interpreter.binary(*ast.sources[ast.c[node]], left, right);          \
+            }
+        FLAT_BINARY(ADD, Object::number(x + y))
+        FLAT_BINARY(SUBTRACT, Object::number(x - y))
+        FLAT_BINARY(MULTIPLY, Object::number(x * y))
+        FLAT_BINARY(DIVIDE, Object::number(x / y))
+        FLAT_BINARY(GREATER, Object::boolean(x > y))
+        FLAT_BINARY(GREATER_EQUAL, Object::boolean(x >= y))
+        FLAT_BINARY(LESS, Object::boolean(x < y))
+        FLAT_BINARY(LESS_EQUAL, Object::boolean(x <= y))
+        #undef FLAT_BINARY
+        case FlatAst::EQUAL:{
+            Object left = evaluate(a);
+            return Object::boolean(interpreter.isEqual(left, evaluate(b)));
+        }
+        case FlatAst::NOT_EQUAL:{
+            Object left = evaluate(a);
+            return Object::boolean(!interpreter.isEqual(left, evaluate(b)));
+        }
+        case FlatAst::AND:{
+            Object left = evaluate(a);
+            if (!interpreter.isTruthy(left)) return left;
+            return evaluate(b);
+        }
+        case FlatAst::OR:{
+            Object left = evaluate(a);
+            if (interpreter.isTruthy(left)) return left;
+            return evaluate(b);
+        }
+
+        // functions and classes
+        case FlatAst::CALL:{
+            CallExpr* curr = static_cast<CallExpr*>(ast.exprs[ast.c[node]]);
+            Object callee = evaluate(a);
+            ArgumentBuffer values(ast.lists[b]);
+            arguments(b, values);
+            return interpreter.call(curr, callee, values.span());
+        }
+        case FlatAst::INVOKE:{
+            CallExpr* curr = static_cast<CallExpr*>(ast.exprs[ast.c[node]]);
+            GetExpr* get = static_cast<GetExpr*>(curr->callee);
+            Object obj = evaluate(a);
+            LoxFunction* method = interpreter.invokedMethod(get, obj);
+            Object callee = method ? Object::nil() : interpreter.getProperty(get, obj);
+            ArgumentBuffer values(ast.lists[b]);
+            arguments(b, values);
+            if (method) return interpreter.invoke(curr, method, obj, values.span());
+            return interpreter.call(curr, callee, values.span());
+        }
+        case FlatAst::GET:
+            return interpreter.getProperty(static_cast<GetExpr*>(ast.exprs[b]), evaluate(a));
+        case FlatAst::SET:{
+            SetExpr* curr = static_cast<SetExpr*>(ast.exprs[ast.c[node]]);
+            Object obj = evaluate(a);
+            interpreter.checkInstance(curr, obj);
+            Object value = evaluate(b);
+            interpreter.setProperty(curr, obj, value);
+            return value;
+        }
+        case FlatAst::SUPER:
+            return interpreter.visitSuperExpr(static_cast<SuperExpr*>(ast.exprs[a]));
+
+        default:
+            return Object::nil();    // Unreachable: statements are executed.
+    }
+}
+
+Completion FlatInterpreter::execute(std::uint32_t node){
+    const std::uint32_t a = ast.a[node];
+    const std::uint32_t b = ast.b[node];
+    switch (ast.kinds[node]){
+        case FlatAst::EXPRESSION:
+            evaluate(a);
+            return Completion::NORMAL;
+        case FlatAst::PRINT:
+            interpreter.print(evaluate(a));
+            return Completion::NORMAL;
+        case FlatAst::DEFINE_LOCAL:{
+            Object value = b == FlatAst::NONE ? Object::nil() : evaluate(b);
+            local(a) = std::move(value);
+            return Completion::NORMAL;
+        }
+        case FlatAst::DEFINE:{
+            Object value = b == FlatAst::NONE ? Object::nil() : evaluate(b);
+            interpreter.defineVariable(static_cast<VarStmt*>(ast.stmts[a])->slot, std::move(value));
+            return Completion::NORMAL;
+        }
+        case FlatAst::BLOCK:{
+            // stops at the first statement that does not complete normally
+            const std::uint32_t length = ast.lists[a];
+            for (std::uint32_t i = 1; i <= length; i++){
+                const Completion completion = execute(ast.lists[a + i]);
+                if (completion != Completion::NORMAL) return completion;
+            }
+            return Completion::NORMAL;
+        }
+
+        case FlatAst::IF:{
+            if (interpreter.isTruthy(evaluate(a))) return execute(b);
+            const std::uint32_t elseBranch = ast.c[node];
+            if (elseBranch != FlatAst::NONE) return execute(elseBranch);
+            return Completion::NORMAL;
+        }
+        case FlatAst::WHILE:
+            while (interpreter.isTruthy(evaluate(a))){
+                const Completion completion = execute(b);
+                if (completion != Completion::NORMAL) return completion;
+            }
+            return Completion::NORMAL;
+
+        case FlatAst::FUNCTION:
+            return interpreter.visitFunctionStmt(static_cast<FunctionStmt*>(ast.stmts[a]));
+        case FlatAst::CLASS:
+            return interpreter.visitClassStmt(static_cast<ClassStmt*>(ast.stmts[a]));
+        case FlatAst::RETURN:
+            interpreter.returnValue = a == FlatAst::NONE ? Object::nil() : evaluate(a);
+            return Completion::RETURN;
+        case FlatAst::TAIL_CALL:{
+            CallExpr* curr = static_cast<CallExpr*>(ast.exprs[ast.c[node]]);
+            Object callee = evaluate(a);
+            ArgumentBuffer values(ast.lists[b]);
+            arguments(b, values);
+            return interpreter.returnCall(curr, callee, values.span());
+        }
+        case FlatAst::TAIL_INVOKE:{
+            CallExpr* curr = static_cast<CallExpr*>(ast.exprs[ast.c[node]]);
+            GetExpr* get = static_cast<GetExpr*>(curr->callee);
+            Object obj = evaluate(a);
+            LoxFunction* method = interpreter.invokedMethod(get, obj);
+            Object callee = method ? Object::nil() : interpreter.getProperty(get, obj);
+            ArgumentBuffer values(ast.lists[b]);
+            arguments(b, values);
+            if (method) return interpreter.returnInvoke(curr, method, obj, values.span());
+            return interpreter.returnCall(curr, callee, values.span());
+        }
+
+        default:
+            return Completion::NORMAL;    // Unreachable: expressions are evaluated.
+    }
+}
+
+void FlatInterpreter::arguments(std::uint32_t list, ArgumentBuffer& values){
+    const std::uint32_t length = ast.lists[list];
+    for (std::uint32_t i = 1; i <= length; i++) values[i - 1] = evaluate(ast.lists[list + i]);
+}
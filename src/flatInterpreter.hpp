@@ -0,0 +1,44 @@
+// requires the Interpreter, whose state (globals, frames) and operations are shared
+#include "interpreter.hpp"
+// requires the lowered AST
+#include "flatAst.hpp"
+// function bodies are run through FunctionStmt::code
+#include "closureCompiler.hpp"
+
+#pragma once
+
+class FlatInterpreter{
+    // Evaluates a FlatAst by recursing over node indices, with a switch on the kind of each node.
+    /*
+        KEY NOTES:
+        1. Runs in the frames of the Interpreter, exactly as the tree walker does:
+           calls go through LoxCallable::call, and statements complete with a Completion.
+        2. Everything but the fast paths (numbers, locals, control flow) is left to the
+           Interpreter's operations (eg. Interpreter::binary), including every runtime error.
+    */
+    public:
+        FlatInterpreter(Interpreter& interpreter, FlatAst& ast) : interpreter(interpreter), ast(ast) {}
+        Object evaluate(std::uint32_t node);
+        Completion execute(std::uint32_t node);
+
+    private:
+        Interpreter& interpreter;
+        FlatAst& ast;
+
+        void arguments(std::uint32_t list, ArgumentBuffer& values);
+        Object& local(std::uint32_t slot){ return interpreter.stack[interpreter.frameBase + slot]; }
+};
+
+class FlatCode : public StmtCode{
+    // A lowered program or function body: the BLOCK [root] of [ast],
+    // run by a FlatInterpreter wherever compiled code runs (see LoxFunction::call)
+    public:
+        FlatAst* ast;
+        std::uint32_t root;
+        FlatCode(FlatAst* ast, std::uint32_t root) : StmtCode(&run), ast(ast), root(root) {}
+    private:
+        static Completion run(StmtCode* self, Interpreter& interpreter){
+            FlatCode* code = static_cast<FlatCode*>(self);
+            return FlatInterpreter(interpreter, *code->ast).execute(code->root);
+        }
+};
@@ -0,0 +1,247 @@
+#include "heap.hpp"
+
+// required for timing collections
+#include <chrono>
+// implementation uses vectors as work lists
+#include <vector>
+#include <algorithm>
+
+Heap::Config Heap::config;
+Heap::Stats Heap::stats;
+size_t Heap::allocated = 0;
+size_t Heap::nextFullCollection = 0;
+size_t Heap::youngAllocations = 0;
+bool Heap::collecting = false;
+Heap::Pool Heap::pools[Heap::poolCount];
+
+// ---LOXOBJECT ALLOCATION---
+void* LoxObject::operator new(size_t size){
+    return Heap::allocate(size);
+}
+void LoxObject::operator delete(void* ptr, size_t size){
+    Heap::deallocate(ptr, size);
+}
+LoxObject::~LoxObject(void){
+    if (gcState != GCState::UNTRACKED) Heap::untrack(this);
+}
+
+namespace {
+    class Sentinel : public LoxObject{
+        // head of a generation list. never tracked, never freed
+        public:
+        Sentinel(void){ gcPrev = this; gcNext = this; }
+        std::string toString(void) override { return "<sentinel>"; }
+    };
+}
+
+LoxObject& Heap::youngList(void){
+    // allocated with the global operator new, and never destroyed:
+    // objects held by static variables may be released during static destruction
+    static LoxObject* list = ::new Sentinel();
+    return *list;
+}
+LoxObject& Heap::oldList(void){
+    static LoxObject* list = ::new Sentinel();
+    return *list;
+}
+void Heap::link(LoxObject& list, LoxObject* obj){
+    // append to the end of a circular list
+    obj->gcPrev = list.gcPrev;
+    obj->gcNext = &list;
+    list.gcPrev->gcNext = obj;
+    list.gcPrev = obj;
+}
+void Heap::unlink(LoxObject* obj){
+    obj->gcPrev->gcNext = obj->gcNext;
+    obj->gcNext->gcPrev = obj->gcPrev;
+    obj->gcPrev = nullptr;
+    obj->gcNext = nullptr;
+}
+
+
+// ---ALLOCATION---
+void* Heap::allocate(size_t size){
+    // collect before allocating, so that no object is ever half-constructed during a collection
+    if (!collecting){
+        if (nextFullCollection == 0) nextFullCollection = config.heapMinimum;
+        if (allocated + size > nextFullCollection) collect(true);
+        else if (youngAllocations >= config.youngThreshold) collect(false);
+    }
+    allocated += size;
+    stats.peakBytes = std::max(stats.peakBytes, allocated);
+    if (size <= poolCount * poolGranularity) return poolAllocate(size);
+    return ::operator new(size);
+}
+void Heap::deallocate(void* ptr, size_t size){
+    allocated -= size;
+    if (collecting){
+        stats.objectsFreed++;
+        stats.bytesFreed += size;
+    }
+    if (size <= poolCount * poolGranularity) poolDeallocate(ptr, size);
+    else ::operator delete(ptr);
+}
+
+void* Heap::poolAllocate(size_t size){
+    // reuse a freed block of this size class if there is one. otherwise carve a new block
+    // from the newest slab, starting a new slab if it is used up
+    const size_t index = (size - 1) / poolGranularity;
+    Pool& pool = pools[index];
+    pool.stats.live++;
+    if (pool.freeList){
+        void* block = pool.freeList;
+        pool.freeList = *static_cast<void**>(block);
+        pool.stats.hits++;
+        return block;
+    }
+    pool.stats.misses++;
+    const size_t blockSize = (index + 1) * poolGranularity;
+    if ((size_t)(pool.end - pool.next) < blockSize){
+        // slabs come from the global operator new, which aligns them for any object
+        pool.next = static_cast<char*>(::operator new(slabSize));
+        pool.end = pool.next + slabSize;
+        pool.stats.footprint += slabSize;
+    }
+    void* block = pool.next;
+    pool.next += blockSize;
+    return block;
+}
+void Heap::poolDeallocate(void* ptr, size_t size){
+    Pool& pool = pools[(size - 1) / poolGranularity];
+    *static_cast<void**>(ptr) = pool.freeList;
+    pool.freeList = ptr;
+    pool.stats.live--;
+}
+void Heap::track(LoxObject* obj){
+    obj->gcState = LoxObject::GCState::YOUNG;
+    link(youngList(), obj);
+    youngAllocations++;
+}
+void Heap::untrack(LoxObject* obj){
+    unlink(obj);
+    obj->gcState = LoxObject::GCState::UNTRACKED;
+}
+size_t Heap::bytesAllocated(void){
+    return allocated;
+}
+
+
+// ---COLLECTION---
+namespace {
+    class SubtractInternal : public HeapVisitor{
+        // removes references between objects under collection from their counts
+        public:
+        void visit(LoxObject* obj) override {
+            if (obj->gcState == LoxObject::GCState::COLLECTING) obj->gcRefs--;
+        }
+    };
+    class MarkReachable : public HeapVisitor{
+        // marks objects under collection as reachable, and queues them for traversal
+        public:
+        std::vector<LoxObject*>& worklist;
+        MarkReachable(std::vector<LoxObject*>& worklist) : worklist(worklist) {}
+        void visit(LoxObject* obj) override {
+            if (obj->gcState == LoxObject::GCState::COLLECTING){
+                obj->gcState = LoxObject::GCState::REACHABLE;
+                worklist.push_back(obj);
+            }
+        }
+    };
+}
+
+void Heap::collect(bool full){
+    using namespace std::chrono;
+    const steady_clock::time_point start = steady_clock::now();
+    collecting = true;
+
+    // gather every object of the collected generations
+    std::vector<LoxObject*> objects = {};
+    LoxObject& young = youngList();
+    LoxObject& old = oldList();
+    for (LoxObject* obj = young.gcNext; obj != &young; obj = obj->gcNext)
+        objects.push_back(obj);
+    if (full){
+        for (LoxObject* obj = old.gcNext; obj != &old; obj = obj->gcNext)
+            objects.push_back(obj);
+    }
+    for (LoxObject* obj : objects){
+        obj->gcState = LoxObject::GCState::COLLECTING;
+        obj->gcRefs = obj->refCount;
+    }
+
+    // subtract internal references. what remains are references from outside:
+    // the interpreter, the native stack and (for young collections) the old generation
+    SubtractInternal subtract;
+    for (LoxObject* obj : objects) obj->traverse(subtract);
+
+    // mark everything reachable from those roots
+    std::vector<LoxObject*> worklist = {};
+    MarkReachable mark(worklist);
+    for (LoxObject* obj : objects){
+        if (obj->gcRefs > 0 && obj->gcState == LoxObject::GCState::COLLECTING){
+            obj->gcState = LoxObject::GCState::REACHABLE;
+            worklist.push_back(obj);
+        }
+    }
+    while (!worklist.empty()){
+        LoxObject* obj = worklist.back();
+        worklist.pop_back();
+        obj->traverse(mark);
+    }
+
+    // promote survivors to the old generation. the rest is garbage
+    std::vector<LoxObject*> garbage = {};
+    for (LoxObject* obj : objects){
+        if (obj->gcState == LoxObject::GCState::REACHABLE){
+            unlink(obj);
+            link(old, obj);
+            obj->gcState = LoxObject::GCState::OLD;
+        }
+        else garbage.push_back(obj);
+    }
+
+    // free garbage: hold every object so none is freed while references are being cleared,
+    // then clear (breaking all cycles) and release
+    for (LoxObject* obj : garbage) obj->retain();
+    for (LoxObject* obj : garbage) obj->clearReferences();
+    for (LoxObject* obj : garbage) obj->release();
+
+    youngAllocations = 0;
+    if (full){
+        nextFullCollection = std::max(config.heapMinimum, (size_t)(allocated * config.heapGrowth));
+        stats.fullCollections++;
+    }
+    else stats.youngCollections++;
+
+    collecting = false;
+    const double pause = duration<double, std::milli>(steady_clock::now() - start).count();
+    stats.totalPause += pause;
+    stats.maxPause = std::max(stats.maxPause, pause);
+}
+
+void Heap::printStats(std::ostream& out){
+    const size_t collections = stats.youngCollections + stats.fullCollections;
+    out << "[gc] collections: " << collections
+        << " (young " << stats.youngCollections << ", full " << stats.fullCollections << ")\n";
+    out << "[gc] freed by collector: " << stats.objectsFreed << " objects, " << stats.bytesFreed << " bytes\n";
+    out << "[gc] pause: total " << stats.totalPause << " ms, max " << stats.maxPause << " ms";
+    if (collections) out << ", mean " << stats.totalPause / collections << " ms";
+    out << "\n";
+    out << "[gc] heap: " << allocated << " bytes live, " << stats.peakBytes << " bytes peak\n";
+}
+void Heap::printPoolStats(std::ostream& out){
+    size_t hits = 0, misses = 0, footprint = 0;
+    for (size_t i = 0; i < poolCount; i++){
+        const PoolStats& pool = pools[i].stats;
+        if (pool.hits + pool.misses == 0) continue;
+        out << "[pool] " << (i + 1) * poolGranularity << " bytes: "
+            << pool.hits + pool.misses << " allocations (" << pool.hits << " hits, " << pool.misses << " misses), "
+            << pool.live << " live, " << pool.footprint << " bytes reserved\n";
+        hits += pool.hits;
+        misses += pool.misses;
+        footprint += pool.footprint;
+    }
+    out << "[pool] total: " << hits + misses << " allocations, " << footprint << " bytes reserved";
+    if (hits + misses) out << ", hit rate " << 100.0 * hits / (hits + misses) << "%";
+    out << "\n";
+}
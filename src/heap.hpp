@@ -0,0 +1,90 @@
+// requires the LoxObject base class
+#include "loxObject.hpp"
+
+// required for printing statistics
+#include <ostream>
+
+#pragma once
+
+class Heap{
+    // Owner of all LoxObjects: counts every allocation, and collects garbage cycles
+    // that reference counting alone cannot free (eg. two instances referring to each other,
+    // or a closure stored in a variable it closes over).
+    /*
+        KEY NOTES:
+        1. Only containers (objects overriding traverse()) are tracked. They register
+           themselves with track() at the end of their constructors.
+        2. Roots are found without scanning the native stack: an object whose reference count
+           is larger than the number of references to it from other tracked objects must be
+           referenced from outside the heap, ie. from the Interpreter's frames or from
+           a C++ local on the native stack. Everything reachable from such an object is live.
+        3. Collection is generational. New containers are YOUNG; survivors of a collection are
+           promoted to OLD. A young collection runs every [youngThreshold] new containers.
+           A full collection runs once the heap grows past [heapGrowth] times its size after
+           the previous full collection (but never below [heapMinimum] bytes).
+           References from OLD to YOUNG objects need no write barrier: they are simply not
+           subtracted during a young collection, so the young object counts as a root.
+        4. Collections only start from operator new, before the new object is constructed.
+        5. Memory for objects of up to [poolCount * poolGranularity] bytes comes from pools,
+           one per size class. A pool carves blocks out of [slabSize]-byte slabs, and keeps
+           freed blocks on a free list for reuse. Slabs are never returned to the system.
+    */
+    public:
+        struct Config{
+            size_t heapMinimum = 1 << 20;
+            double heapGrowth = 2.0;
+            size_t youngThreshold = 1000;
+        };
+        struct Stats{
+            size_t youngCollections = 0;
+            size_t fullCollections = 0;
+            size_t objectsFreed = 0;
+            size_t bytesFreed = 0;
+            double totalPause = 0;     // in milliseconds
+            double maxPause = 0;       // in milliseconds
+            size_t peakBytes = 0;
+        };
+        struct PoolStats{
+            size_t hits = 0;         // allocations served from the free list
+            size_t misses = 0;       // allocations carved from a slab
+            size_t live = 0;         // blocks in use
+            size_t footprint = 0;    // bytes of slabs reserved
+        };
+        static Config config;
+        static Stats stats;
+
+        static void* allocate(size_t size);
+        static void deallocate(void* ptr, size_t size);
+        static void track(LoxObject* obj);
+        static void untrack(LoxObject* obj);
+
+        static void collect(bool full);
+        static size_t bytesAllocated(void);
+        static void printStats(std::ostream& out);
+        static void printPoolStats(std::ostream& out);
+
+    private:
+        static size_t allocated;
+        static size_t nextFullCollection;
+        static size_t youngAllocations;
+        static bool collecting;
+        // circular lists with sentinel nodes, one per generation
+        static LoxObject& youngList(void);
+        static LoxObject& oldList(void);
+        static void link(LoxObject& list, LoxObject* obj);
+        static void unlink(LoxObject* obj);
+
+        // size-class pools. pools[i] holds blocks of (i + 1) * poolGranularity bytes
+        static constexpr size_t poolGranularity = 16;
+        static constexpr size_t poolCount = 16;
+        static constexpr size_t slabSize = 1 << 16;
+        struct Pool{
+            void* freeList = nullptr;    // each free block holds a pointer to the next
+            char* next = nullptr;        // unused part of the newest slab
+            char* end = nullptr;
+            PoolStats stats;
+        };
+        static Pool pools[poolCount];
+        static void* poolAllocate(size_t size);
+        static void poolDeallocate(void* ptr, size_t size);
+};
@@ -1,44 +1,97 @@
 #include "interpreter.hpp"
+// requires compiled programs, to run them
+#include "closureCompiler.hpp"
+
+// required to move the arguments of tail calls
+#include <iterator>
 
 Interpreter::Interpreter(){
     // initialize global environment, as well as define native functions
-    globals = std::make_shared<Environment>(nullptr);
-    globals->define("clock", Object::function(std::make_shared<Clock>()));
+    globals = {};
+    globalSlots = {};
+    defineGlobal(declareGlobal("clock", true), Object::function(makeRef<Clock>()));
 
-    env = globals;
-    // initialize locals as empty. this will be filled during resolving
-    locals = {};
+    // top-level code has no enclosing call
+    stack = {};
+    frameBase = 0;
+    closure = nullptr;
 }
 
-Object Interpreter::evaluate(std::shared_ptr<Expr> expr){
-    return std::any_cast<Object>(visit(expr));
-}
-std::any Interpreter::visit(std::shared_ptr<Expr> curr){
-    return curr->accept(*this);
+Object Interpreter::evaluate(Expr* expr){
+    return visit(expr);
 }
 
-void Interpreter::execute(std::shared_ptr<Stmt> stmt){
-    visit(stmt);
+Completion Interpreter::execute(Stmt* stmt){
+    return visit(stmt);
 }
-void Interpreter::execute(std::vector<std::shared_ptr<Stmt>> statements){
-    for (std::shared_ptr<Stmt> stmt : statements) visit(stmt);
-    return;
+Completion Interpreter::execute(std::vector<Stmt*>& statements){
+    // stops at the first statement that does not complete normally
+    for (Stmt*& stmt : statements){
+        const Completion completion = visit(stmt);
+        if (completion != Completion::NORMAL) return completion;
+    }
+    return Completion::NORMAL;
+}
+void Interpreter::interpret(std::vector<Stmt*>& statements, int frameSize){
+    // executes a resolved program in a frame of [frameSize] slots (locals of top-level blocks)
+    // the frame is popped afterwards, even on a RuntimeError
+    stack.resize(frameSize);
+    frameBase = 0;
+    closure = nullptr;
+    try{
+        execute(statements);
+    }
+    catch(...){
+        stack.clear();
+        throw;
+    }
+    stack.clear();
 }
-std::any Interpreter::visit(std::shared_ptr<Stmt> curr){
-    return curr->accept(*this);
+void Interpreter::interpret(StmtCode* program, int frameSize){
+    // executes a program compiled by the ClosureCompiler, in the same way
+    stack.resize(frameSize);
+    frameBase = 0;
+    closure = nullptr;
+    try{
+        (*program)(*this);
+    }
+    catch(...){
+        stack.clear();
+        throw;
+    }
+    stack.clear();
 }
 
 // ---EXPR CHILD CLASSES---
-std::any Interpreter::visitLiteralExpr(std::shared_ptr<LiteralExpr> curr){
+Object Interpreter::visitLiteralExpr(LiteralExpr* curr){
     return curr->obj;
 }
-std::any Interpreter::visitGroupingExpr(std::shared_ptr<GroupingExpr> curr){
+Object Interpreter::visitGroupingExpr(GroupingExpr* curr){
     return evaluate(curr->expr);
 }
 
-std::any Interpreter::visitUnaryExpr(std::shared_ptr<UnaryExpr> curr){
-    Object obj = evaluate(curr->expr);
-    Token op = curr->op;
+Object Interpreter::visitUnaryExpr(UnaryExpr* curr){
+    return unary(curr, evaluate(curr->expr));
+}
+Object Interpreter::unary(UnaryExpr* curr, const Object& obj){
+    // runs the specialisation of the node, if its guard holds
+    switch (curr->specialization){
+        case UnaryExpr::NUMBER_NEGATE:
+            if (obj.type == Object::NUMBER) return Object::number(-obj.literalNumber);
+            break;
+        case UnaryExpr::NOT:
+            return Object::boolean(!isTruthy(obj));
+        case UnaryExpr::GENERIC:
+            return unary(curr->op, obj);
+        case UnaryExpr::UNSPECIALIZED:
+            curr->specialization = specialize(curr->op, obj);
+            return unary(curr->op, obj);
+    }
+    // the guard failed: stay generic from now on
+    curr->specialization = UnaryExpr::GENERIC;
+    return unary(curr->op, obj);
+}
+Object Interpreter::unary(const Token& op, const Object& obj){
     if (op.type == Token::BANG){
         return Object::boolean(!isTruthy(obj));
     }
@@ -50,11 +103,58 @@ std::any Interpreter::visitUnaryExpr(std::shared_ptr<UnaryExpr> curr){
     else throw error(op, "UNIMPLEMENTED unary operator!");    // Unreachable.
 }
 
-std::any Interpreter::visitBinaryExpr(std::shared_ptr<BinaryExpr> curr){
+Object Interpreter::visitBinaryExpr(BinaryExpr* curr){
     Object left = evaluate(curr->left);
     Object right = evaluate(curr->right);
-    Token op = curr->op;
-
+    return binary(curr, left, right);
+}
+Object Interpreter::binary(BinaryExpr* curr, const Object& left, const Object& right){
+    // runs the specialisation of the node, if its guard holds
+    switch (curr->specialization){
+        case BinaryExpr::NUMBER_ADD:
+            if (left.type == Object::NUMBER && right.type == Object::NUMBER) return Object::number(left.literalNumber + right.literalNumber);
+            break;
+        case BinaryExpr::NUMBER_SUBTRACT:
+            if (left.type == Object::NUMBER && right.type == Object::NUMBER) return Object::number(left.literalNumber - right.literalNumber);
+            break;
+        case BinaryExpr::NUMBER_MULTIPLY:
+            if (left.type == Object::NUMBER && right.type == Object::NUMBER) return Object::number(left.literalNumber * right.literalNumber);
+            break;
+        case BinaryExpr::NUMBER_DIVIDE:
+            if (left.type == Object::NUMBER && right.type == Object::NUMBER) return Object::number(left.literalNumber / right.literalNumber);
+            break;
+        case BinaryExpr::NUMBER_GREATER:
+            if (left.type == Object::NUMBER && right.type == Object::NUMBER) return Object::boolean(left.literalNumber > right.literalNumber);
+            break;
+        case BinaryExpr::NUMBER_GREATER_EQUAL:
+            if (left.type == Object::NUMBER && right.type == Object::NUMBER) return Object::boolean(left.literalNumber >= right.literalNumber);
+            break;
+        case BinaryExpr::NUMBER_LESS:
+            if (left.type == Object::NUMBER && right.type == Object::NUMBER) return Object::boolean(left.literalNumber < right.literalNumber);
+            break;
+        case BinaryExpr::NUMBER_LESS_EQUAL:
+            if (left.type == Object::NUMBER && right.type == Object::NUMBER) return Object::boolean(left.literalNumber <= right.literalNumber);
+            break;
+        case BinaryExpr::NUMBER_EQUAL:
+            if (left.type == Object::NUMBER && right.type == Object::NUMBER) return Object::boolean(left.literalNumber == right.literalNumber);
+            break;
+        case BinaryExpr::NUMBER_NOT_EQUAL:
+            if (left.type == Object::NUMBER && right.type == Object::NUMBER) return Object::boolean(left.literalNumber != right.literalNumber);
+            break;
+        case BinaryExpr::STRING_CONCAT:
+            if (left.isString() && right.isString()) return LoxRope::concat(left, right);
+            break;
+        case BinaryExpr::GENERIC:
+            return binary(curr->op, left, right);
+        case BinaryExpr::UNSPECIALIZED:
+            curr->specialization = specialize(curr->op, left, right);
+            return binary(curr->op, left, right);
+    }
+    // the guard failed: stay generic from now on, rather than respecialising back and forth
+    curr->specialization = BinaryExpr::GENERIC;
+    return binary(curr->op, left, right);
+}
+Object Interpreter::binary(const Token& op, const Object& left, const Object& right){
     switch (op.type){
         // boolean operators based on truthiness
         case Token::EQUAL_EQUAL:
@@ -85,8 +185,8 @@ std::any Interpreter::visitBinaryExpr(std::shared_ptr<BinaryExpr> curr){
         case Token::PLUS:{
             if (left.type == Object::NUMBER && left.type == right.type)
                 return Object::number(left.literalNumber + right.literalNumber);
-            else if (left.type== Object::STRING && left.type == right.type)
-                return Object::string(left.literalString + right.literalString);
+            else if (left.isString() && right.isString())
+                return LoxRope::concat(left, right);
             else throw error(op, "Operands must be numbers or strings.");
         }
         case Token::MINUS:
@@ -104,29 +204,41 @@ std::any Interpreter::visitBinaryExpr(std::shared_ptr<BinaryExpr> curr){
             else throw error(op, "Operands must be numbers.");
 
         default:
-            throw error(curr->op, "UNIMPLEMENTED binary operator!");    // Unreachable.
+            throw error(op, "UNIMPLEMENTED binary operator!");    // Unreachable.
     }
 }
 
-std::any Interpreter::visitVariableExpr(std::shared_ptr<VariableExpr> curr){
+Object Interpreter::visitVariableExpr(VariableExpr* curr){
     // returns stored value as statically resolved by Resolver
     // relies on Resolver being fully implemented
-    return lookUpVariable(curr->name, curr);
+    if (curr->slot.kind != VariableSlot::GLOBAL) return localVariable(curr->slot);
+    return globalVariable(curr);
+}
+Object Interpreter::globalVariable(VariableExpr* curr){
+    // constant globals never change once defined: read them from the node itself
+    if (curr->cacheEpoch == globalEpoch) return curr->cachedGlobal;
+    Object& value = getGlobal(curr->name, curr->slot.index);
+    if (globals[curr->slot.index].constant){
+        curr->cachedGlobal = value;
+        curr->cacheEpoch = globalEpoch;
+    }
+    return value;
 }
-std::any Interpreter::visitAssignExpr(std::shared_ptr<AssignExpr> curr){
+Object Interpreter::visitAssignExpr(AssignExpr* curr){
     // sets the value of the variable to the evaluated expression,
     // binded to static scope as resolved by Resolver
     // relies on Resolver being fully implemented
     // returns the evaluated expression
     Object obj = evaluate(curr->expr);
-
-    // local variable / global variable
-    if (locals.count(curr)) env->assignAt(locals.at(curr), curr->name, obj);
-    else globals->assign(curr->name, obj);
-
+    assign(curr, obj);
     return obj;
 }
-std::any Interpreter::visitLogicalExpr(std::shared_ptr<LogicalExpr> curr){
+void Interpreter::assign(AssignExpr* curr, const Object& obj){
+    // local variable / global variable
+    if (curr->slot.kind != VariableSlot::GLOBAL) localVariable(curr->slot) = obj;
+    else assignGlobal(curr->name, curr->slot.index, obj);
+}
+Object Interpreter::visitLogicalExpr(LogicalExpr* curr){
     Object left = evaluate(curr->left);
 
     // There are only 2 operators: AND, OR
@@ -143,72 +255,98 @@ std::any Interpreter::visitLogicalExpr(std::shared_ptr<LogicalExpr> curr){
     return evaluate(curr->right);
 }
 
-std::any Interpreter::visitCallExpr(std::shared_ptr<CallExpr> curr){
+Object Interpreter::visitCallExpr(CallExpr* curr){
+    if (curr->callee->type == Expr::GET){
+        // a method call. the method is looked up before the arguments are evaluated,
+        // as the callee would be
+        GetExpr* get = static_cast<GetExpr*>(curr->callee);
+        Object obj = evaluate(get->expr);
+        LoxFunction* method = invokedMethod(get, obj);
+        Object callee = method ? Object::nil() : getProperty(get, obj);
+        ArgumentBuffer arguments(curr->arguments.size());
+        for (size_t i = 0; i < arguments.size(); i++){
+            arguments[i] = evaluate(curr->arguments[i]);
+        }
+        if (method) return invoke(curr, method, obj, arguments.span());
+        return call(curr, callee, arguments.span());
+    }
+
     // evaluate callee and arguments
     Object callee = evaluate(curr->callee);
-    std::vector<Object> arguments = {};
-    for (std::shared_ptr<Expr> expr : curr->arguments){
-        arguments.push_back(evaluate(expr));
+    ArgumentBuffer arguments(curr->arguments.size());
+    for (size_t i = 0; i < arguments.size(); i++){
+        arguments[i] = evaluate(curr->arguments[i]);
     }
-
-    // if callee is not function or class, throw runtime error
-    if (!(callee.type == Object::LOX_CALLABLE || callee.type == Object::LOX_CLASS))
-        throw error(curr->paren, "Can only call functions and classes.");
-    
-    // get LoxCallable from object, check arity and return call value
-    // (LoxClass is implicitly upcast to LoxCallable)
-    std::shared_ptr<LoxCallable> callable;
-    if (callee.type == Object::LOX_CALLABLE) callable = callee.loxFunction;
-    else callable = callee.loxClass;
-
-    if (arguments.size() != callable->arity())
-        throw error(curr->paren, "Expected " + std::to_string(callable->arity()) + " arguments but got " + std::to_string(arguments.size()) + ".");
-    
-    return callable->call(*this, arguments);
+    return call(curr, callee, arguments.span());
 }
 
-std::any Interpreter::visitGetExpr(std::shared_ptr<GetExpr> curr){
-    Object obj = evaluate(curr->expr);
+Object Interpreter::visitGetExpr(GetExpr* curr){
+    return getProperty(curr, evaluate(curr->expr));
+}
+Object Interpreter::getProperty(GetExpr* curr, const Object& obj){
     if (obj.type == Object::LOX_INSTANCE){
-        return obj.loxInstance->get(curr->name);
+        return obj.as<LoxInstance>()->get(curr->name, curr->cache);
     }
     throw error(curr->name, "Only instances have properties.");
 }
 
-std::any Interpreter::visitSetExpr(std::shared_ptr<SetExpr> curr){
+LoxFunction* Interpreter::invokedMethod(GetExpr* curr, const Object& obj){
+    if (obj.type != Object::LOX_INSTANCE) return nullptr;
+    return obj.as<LoxInstance>()->method(curr->name, curr->cache);
+}
+Object Interpreter::invoke(CallExpr* curr, LoxFunction* method, const Object& obj, std::span<Object> arguments){
+    // [method] is kept alive by the class of [obj]
+    checkInvoke(curr, method, arguments.size());
+    return method->call(*this, arguments, obj.as<LoxInstance>());
+}
+void Interpreter::checkInvoke(CallExpr* curr, LoxFunction* method, size_t arguments){
+    if (arguments != method->declaration->params.size())
+        throw error(curr->paren, "Expected " + std::to_string(method->declaration->params.size()) + " arguments but got " + std::to_string(arguments) + ".");
+}
+
+Object Interpreter::visitSetExpr(SetExpr* curr){
     Object obj = evaluate(curr->expr);
-    if (obj.type == Object::LOX_INSTANCE){
-        Object value = evaluate(curr->value);
-        obj.loxInstance->set(curr->name, value);
-        return value;
-    }
-    throw error(curr->name, "Only instances have properties.");
+    checkInstance(curr, obj);
+    Object value = evaluate(curr->value);
+    setProperty(curr, obj, value);
+    return value;
+}
+void Interpreter::checkInstance(SetExpr* curr, const Object& obj){
+    // the object is checked before the value is evaluated
+    if (obj.type != Object::LOX_INSTANCE) throw error(curr->name, "Only instances have properties.");
+}
+void Interpreter::setProperty(SetExpr* curr, const Object& obj, const Object& value){
+    // [obj] has been checked by checkInstance
+    obj.as<LoxInstance>()->set(curr->name, value, curr->cache);
 }
 
-std::any Interpreter::visitThisExpr(std::shared_ptr<ThisExpr> curr){
-    return lookUpVariable(curr->keyword, curr);
+Object Interpreter::visitThisExpr(ThisExpr* curr){
+    return lookUpVariable(curr->keyword, curr->slot);
 }
 
-std::any Interpreter::visitSuperExpr(std::shared_ptr<SuperExpr> curr){
-    int distance = locals.at(curr);
-    std::shared_ptr<LoxClass> superclass = env->getAt(distance, "super").loxClass;
-    std::shared_ptr<LoxInstance> instance = env->getAt(distance - 1, "this").loxInstance;
+Object Interpreter::visitSuperExpr(SuperExpr* curr){
+    // 'super' is captured from the scope enclosing the methods; 'this' is a local of the method
+    Object superclass = localVariable(curr->slot);
+    Object instance = localVariable(curr->thisSlot);
 
-    std::shared_ptr<LoxFunction> method = superclass->findMethod(curr->method.lexeme);
-    return Object::function(method->bind(instance));
+    Ref<LoxFunction> method = superclass.as<LoxClass>()->findMethod(curr->method.lexeme);
+    if (!method) throw error(curr->method, "Undefined property '" + curr->method.lexeme + "'.");
+    return Object::function(method->bind(instance.as<LoxInstance>()));
 }
 
 
 /// ---STMT CHILD CLASSES---
-std::any Interpreter::visitExpressionStmt(std::shared_ptr<ExpressionStmt> curr){
+Completion Interpreter::visitExpressionStmt(ExpressionStmt* curr){
     // evaluate the expression even if its value is unused
     // this causes eg. 45 + "lorem"; to correctly throw a RuntimeError
     evaluate(curr->expr);
-    return nullptr;
+    return Completion::NORMAL;
 }
-std::any Interpreter::visitPrintStmt(std::shared_ptr<PrintStmt> curr){
-    Object obj = evaluate(curr->expr);
-
+Completion Interpreter::visitPrintStmt(PrintStmt* curr){
+    print(evaluate(curr->expr));
+    return Completion::NORMAL;
+}
+void Interpreter::print(Object obj){
     // The .0 workaround for Codecrafters.io. You know the deal.
     std::string s;
     if (obj.type == Object::NUMBER){
@@ -219,117 +357,284 @@ std::any Interpreter::visitPrintStmt(std::shared_ptr<PrintStmt> curr){
     else s = obj.toString(true);
 
     std::cout << s << "\n";
-    return nullptr;
 }
-std::any Interpreter::visitVarStmt(std::shared_ptr<VarStmt> curr){
-    Token name = curr->name;
+Completion Interpreter::visitVarStmt(VarStmt* curr){
     Object initializer = curr->initializer ? evaluate(curr->initializer) : Object::nil();
-    env->define(name.lexeme, initializer);
-    return nullptr;
+    defineVariable(curr->slot, initializer);
+    return Completion::NORMAL;
 }
-std::any Interpreter::visitBlockStmt(std::shared_ptr<BlockStmt> curr){
-    // create new scope for execution of block
-    executeBlock(curr->statements, std::make_shared<Environment>(env));
-    return nullptr;
+Completion Interpreter::visitBlockStmt(BlockStmt* curr){
+    // no new scope at runtime: the Resolver assigned the block's locals to slots of the current frame
+    return execute(curr->statements);
 }
 
-std::any Interpreter::visitIfStmt(std::shared_ptr<IfStmt> curr){
-    if (isTruthy(evaluate(curr->condition))) execute(curr->thenBranch);
-    else if (curr->elseBranch) execute(curr->elseBranch);
-    return nullptr;
+Completion Interpreter::visitIfStmt(IfStmt* curr){
+    if (isTruthy(evaluate(curr->condition))) return execute(curr->thenBranch);
+    else if (curr->elseBranch) return execute(curr->elseBranch);
+    return Completion::NORMAL;
 }
-std::any Interpreter::visitWhileStmt(std::shared_ptr<WhileStmt> curr){
-    while (isTruthy(evaluate(curr->condition)))
-        execute(curr->body);
-    return nullptr;
+Completion Interpreter::visitWhileStmt(WhileStmt* curr){
+    while (isTruthy(evaluate(curr->condition))){
+        const Completion completion = execute(curr->body);
+        if (completion != Completion::NORMAL) return completion;
+    }
+    return Completion::NORMAL;
 }
 
-std::any Interpreter::visitFunctionStmt(std::shared_ptr<FunctionStmt> curr){
-    // create and store LoxFunction in local scope
-    std::shared_ptr<LoxFunction> func = std::make_shared<LoxFunction>(curr, env);
-    env->define(curr->name.lexeme, Object::function(func));
-    return nullptr;
-}
-std::any Interpreter::visitReturnStmt(std::shared_ptr<ReturnStmt> curr){
-    // return expression, if any. LoxReturn is caught at end of function call
-    Object obj;
-    if (curr->expr) obj = evaluate(curr->expr);
-    else obj = Object::nil();
-    throw LoxReturn(obj);
-    return nullptr;    // Unreachable.
-}
-std::any Interpreter::visitClassStmt(std::shared_ptr<ClassStmt> curr){
+Completion Interpreter::visitFunctionStmt(FunctionStmt* curr){
+    // create and store LoxFunction in its variable
+    // a captured function is boxed first, so that it may capture itself (recursion)
+    if (curr->slot.kind == VariableSlot::BOXED){
+        defineVariable(curr->slot, Object::nil());
+        localVariable(curr->slot) = Object::function(makeRef<LoxFunction>(curr, captureUpvalues(*curr)));
+    }
+    else defineVariable(curr->slot, Object::function(makeRef<LoxFunction>(curr, captureUpvalues(*curr))));
+    return Completion::NORMAL;
+}
+Completion Interpreter::visitReturnStmt(ReturnStmt* curr){
+    // return expression, if any. the enclosing statements complete with RETURN
+    // up to the end of the function call, which takes the value
+    if (curr->tailCall) return tailCall(curr->tailCall);
+    if (curr->expr) returnValue = evaluate(curr->expr);
+    else returnValue = Object::nil();
+    return Completion::RETURN;
+}
+Completion Interpreter::visitClassStmt(ClassStmt* curr){
     // create and store LoxClass in local scope
     // declares class name first to allow for recursive definitions of functions
     // all methods are also cast from Function:Stmt to LoxFunction
 
     // get superclass, if any
-    Object superclassObj = Object::klass(nullptr);
+    Object superclassObj = Object::nil();
+    Ref<LoxClass> superclass = nullptr;
     if (curr->superclass){
         Object obj = evaluate(curr->superclass);
         if (obj.type != Object::LOX_CLASS)
             throw error(curr->superclass->name, "Superclass must be a class.");
-        else superclassObj = obj;
+        else {
+            superclassObj = obj;
+            superclass = obj.as<LoxClass>();
+        }
     }
 
-    env->define(curr->name.lexeme, Object::nil());
+    // a captured class name is boxed before the methods capture it
+    // (otherwise the class is only defined once complete: methods look it up when called)
+    if (curr->slot.kind == VariableSlot::BOXED) defineVariable(curr->slot, Object::nil());
 
-    // if superclass present, create new nested environment ('super' support)
-    if (curr->superclass){
-        env = std::make_shared<Environment>(env);
-        env->define("super", superclassObj);
-    }
+    // if superclass present, define 'super' for the methods to capture
+    if (curr->superclass) defineVariable(curr->superSlot, superclassObj);
 
-    std::unordered_map<std::string, std::shared_ptr<LoxFunction>> methods = {};
-    for (std::shared_ptr<FunctionStmt> method : curr->methods){
+    std::unordered_map<std::string, Ref<LoxFunction>> methods = {};
+    for (FunctionStmt* method : curr->methods){
         bool isInitializer = method->name.lexeme == "init";
-        std::shared_ptr<LoxFunction> loxFunc = std::make_shared<LoxFunction>(method, env, isInitializer);
+        Ref<LoxFunction> loxFunc = makeRef<LoxFunction>(method, captureUpvalues(*method), isInitializer);
         methods.insert({method->name.lexeme, loxFunc});
     }
 
-    std::shared_ptr<LoxClass> loxClass = std::make_shared<LoxClass>(curr->name.lexeme, superclassObj.loxClass, methods);
+    Ref<LoxClass> loxClass = makeRef<LoxClass>(curr->name.lexeme, superclass, methods);
 
-    // end scope for superclass (if any)
-    if (curr->superclass) env = env->enclosing;
-
-    env->assign(curr->name, Object::klass(loxClass));
-    return nullptr;
+    if (curr->slot.kind == VariableSlot::BOXED) localVariable(curr->slot) = Object::klass(loxClass);
+    else defineVariable(curr->slot, Object::klass(loxClass));
+    return Completion::NORMAL;
 }
 
 // ---HELPER FUNCTIONS---
 
-void Interpreter::executeBlock(std::vector<std::shared_ptr<Stmt>>& statements, std::shared_ptr<Environment> newScope){
-    // change scope to new and execute statements in block. restore scope afterwards
-    // if an exception is caught, restore scope before rethrowing
-    const std::shared_ptr<Environment> prev = env;
-    try{
-        env = newScope;
-        execute(statements);
-        env = prev; 
-    }
-    catch(...){
-        env = prev;
-        throw;
+UnaryExpr::Specialization Interpreter::specialize(const Token& op, const Object& obj){
+    // the specialisation of a unary expression, for the operand it was first evaluated with
+    if (op.type == Token::BANG) return UnaryExpr::NOT;
+    if (obj.type == Object::NUMBER) return UnaryExpr::NUMBER_NEGATE;
+    return UnaryExpr::GENERIC;
+}
+BinaryExpr::Specialization Interpreter::specialize(const Token& op, const Object& left, const Object& right){
+    // the specialisation of a binary expression, for the operands it was first evaluated with
+    // operands of any other types (including the errors) are left generic
+    if (left.type == Object::NUMBER && right.type == Object::NUMBER){
+        switch (op.type){
+            case Token::PLUS: return BinaryExpr::NUMBER_ADD;
+            case Token::MINUS: return BinaryExpr::NUMBER_SUBTRACT;
+            case Token::STAR: return BinaryExpr::NUMBER_MULTIPLY;
+            case Token::SLASH: return BinaryExpr::NUMBER_DIVIDE;
+            case Token::GREATER: return BinaryExpr::NUMBER_GREATER;
+            case Token::GREATER_EQUAL: return BinaryExpr::NUMBER_GREATER_EQUAL;
+            case Token::LESS: return BinaryExpr::NUMBER_LESS;
+            case Token::LESS_EQUAL: return BinaryExpr::NUMBER_LESS_EQUAL;
+            case Token::EQUAL_EQUAL: return BinaryExpr::NUMBER_EQUAL;
+            case Token::BANG_EQUAL: return BinaryExpr::NUMBER_NOT_EQUAL;
+            default: return BinaryExpr::GENERIC;
+        }
     }
+    if (op.type == Token::PLUS && left.isString() && right.isString()) return BinaryExpr::STRING_CONCAT;
+    return BinaryExpr::GENERIC;
 }
 
-void Interpreter::resolve(std::shared_ptr<Expr> expr, int steps){
-    locals.insert({expr, steps});
+Object Interpreter::call(CallExpr* curr, const Object& callee, std::span<Object> arguments){
+    // user-defined functions are called directly, rather than through LoxCallable::call
+    LoxCallable* callable = checkCall(curr, callee, arguments.size());
+    LoxFunction* function = curr->cache.function;
+    if (function) return function->call(*this, arguments, function->receiver.get());
+    return callable->call(*this, arguments);
 }
-Object Interpreter::lookUpVariable(Token name, std::shared_ptr<Expr> expr){
-    // if locals contains the variable, it is static-scope
-    if (locals.count(expr)){
-        int distance = locals.at(expr);
-        return env->getAt(distance, name);
+LoxCallable* Interpreter::checkCallSlow(CallExpr* curr, const Object& callee, size_t arguments){
+    // if callee is not function or class, throw runtime error
+    if (!(callee.type == Object::LOX_CALLABLE || callee.type == Object::LOX_CLASS))
+        throw error(curr->paren, "Can only call functions and classes.");
+
+    // get LoxCallable from object and check arity
+    // (LoxClass is implicitly upcast to LoxCallable)
+    LoxCallable* callable = callee.as<LoxCallable>();
+
+    if (arguments != (size_t)callable->arity())
+        throw error(curr->paren, "Expected " + std::to_string(callable->arity()) + " arguments but got " + std::to_string(arguments) + ".");
+
+    // the arity of a call site never changes: calling the same callee again needs no checks
+    curr->cache.callee = callee;
+    curr->cache.function = callable->function();
+    return callable;
+}
+Completion Interpreter::tailCall(CallExpr* curr){
+    if (curr->callee->type == Expr::GET){
+        GetExpr* get = static_cast<GetExpr*>(curr->callee);
+        Object obj = evaluate(get->expr);
+        LoxFunction* method = invokedMethod(get, obj);
+        Object callee = method ? Object::nil() : getProperty(get, obj);
+        ArgumentBuffer arguments(curr->arguments.size());
+        for (size_t i = 0; i < arguments.size(); i++){
+            arguments[i] = evaluate(curr->arguments[i]);
+        }
+        if (method) return returnInvoke(curr, method, obj, arguments.span());
+        return returnCall(curr, callee, arguments.span());
     }
+    Object callee = evaluate(curr->callee);
+    ArgumentBuffer arguments(curr->arguments.size());
+    for (size_t i = 0; i < arguments.size(); i++){
+        arguments[i] = evaluate(curr->arguments[i]);
+    }
+    return returnCall(curr, callee, arguments.span());
+}
+Completion Interpreter::returnCall(CallExpr* curr, const Object& callee, std::span<Object> arguments){
+    // a call in tail position: a user-defined function is not called from here, but handed
+    // to the function call being completed, which runs it in its own frame.
+    // the C++ stack does not grow, so tail-recursive loops run in constant space
+    LoxCallable* callable = checkCall(curr, callee, arguments.size());
+
+    // classes and native functions are called as usual
+    LoxFunction* function = curr->cache.function;
+    if (!function){
+        returnValue = callable->call(*this, arguments);
+        return Completion::RETURN;
+    }
+    tailCallee = function;
+    tailArguments.assign(std::make_move_iterator(arguments.begin()), std::make_move_iterator(arguments.end()));
+    return Completion::TAIL_CALL;
+}
+Completion Interpreter::returnInvoke(CallExpr* curr, LoxFunction* method, const Object& obj, std::span<Object> arguments){
+    // a method call in tail position, run in the frame being completed with [obj] as 'this'
+    checkInvoke(curr, method, arguments.size());
+    tailCallee = method;
+    tailReceiver = obj.as<LoxInstance>();
+    tailArguments.assign(std::make_move_iterator(arguments.begin()), std::make_move_iterator(arguments.end()));
+    return Completion::TAIL_CALL;
+}
+
+Object Interpreter::lookUpVariable(const Token& name, const VariableSlot& slot){
+    // if the Resolver found the variable in a local scope, it is static-scope
+    if (slot.kind != VariableSlot::GLOBAL) return localVariable(slot);
     // variable is in global scope. fetch and return.
-    else return globals->get(name);
+    else return getGlobal(name, slot.index);
+}
+void Interpreter::defineVariable(const VariableSlot& slot, Object value){
+    // defines a variable in the current frame (boxing it if captured) or in the global table
+    switch (slot.kind){
+        case VariableSlot::LOCAL:
+            stack[frameBase + slot.index] = std::move(value);
+            break;
+        case VariableSlot::BOXED:
+            stack[frameBase + slot.index] = Object::upvalue(makeRef<LoxUpvalue>(std::move(value)));
+            break;
+        default:
+            defineGlobal(slot.index, std::move(value));
+    }
+}
+Object& Interpreter::localVariable(const VariableSlot& slot){
+    // the storage of a resolved local variable (which always exists after resolving)
+    // WARNING: the reference is invalidated by the next call, which may grow the stack
+    switch (slot.kind){
+        case VariableSlot::LOCAL:
+            return stack[frameBase + slot.index];
+        case VariableSlot::BOXED:
+            return stack[frameBase + slot.index].as<LoxUpvalue>()->value;
+        default:
+            return closure->upvalues[slot.index]->value;
+    }
+}
+std::vector<Ref<LoxUpvalue>> Interpreter::captureUpvalues(FunctionStmt& function){
+    // collects the variables a new closure of [function] captures:
+    // boxes in the current frame, or upvalues of the current closure
+    std::vector<Ref<LoxUpvalue>> upvalues = {};
+    upvalues.reserve(function.upvalues.size());
+    for (const CapturedVariable& captured : function.upvalues){
+        if (captured.isLocal) upvalues.push_back(stack[frameBase + captured.index].as<LoxUpvalue>());
+        else upvalues.push_back(closure->upvalues[captured.index]);
+    }
+    return upvalues;
+}
+
+int Interpreter::globalSlot(const std::string& name){
+    // index of global [name] in the global table. creates an undefined entry if needed.
+    // the mapping persists across runs, so that REPL lines share globals
+    auto it = globalSlots.find(name);
+    if (it != globalSlots.end()) return it->second;
+    int slot = (int)globals.size();
+    globals.push_back(Global());
+    globalSlots.insert({name, slot});
+    return slot;
+}
+int Interpreter::declareGlobal(const std::string& name, bool constant){
+    // records a top-level declaration of [name]. [constant] is true for 'fun' and 'class'
+    // a redeclaration (including in a later REPL line) makes the global non-constant
+    int slot = globalSlot(name);
+    Global& global = globals[slot];
+    global.declarations++;
+    bool wasConstant = global.constant;
+    global.constant = constant && global.declarations == 1 && !global.assigned;
+    if (wasConstant && !global.constant) globalEpoch++;
+    return slot;
+}
+void Interpreter::assignedGlobal(int slot){
+    // records an assignment to a global anywhere in the program
+    Global& global = globals[slot];
+    global.assigned = true;
+    if (global.constant){
+        global.constant = false;
+        globalEpoch++;
+    }
+}
+
+void Interpreter::defineGlobal(int slot, Object value){
+    globals[slot].value = std::move(value);
+    globals[slot].defined = true;
+}
+Object& Interpreter::getGlobal(const Token& name, int slot){
+    Global& global = globals[slot];
+    if (!global.defined)
+        throw LoxError::RuntimeError(name, "Undefined variable '" + name.lexeme + "'");
+    return global.value;
+}
+void Interpreter::assignGlobal(const Token& name, int slot, Object value){
+    Global& global = globals[slot];
+    if (!global.defined)
+        throw LoxError::RuntimeError(name, "Undefined variable '" + name.lexeme + "'");
+    global.value = std::move(value);
 }
 
-bool Interpreter::isTruthy(Object obj){
+bool Interpreter::isTruthy(const Object& obj){
     return !(obj.type == Object::NIL || (obj.type == Object::BOOL && obj.literalBool == false));
 }
-bool Interpreter::isEqual(Object a, Object b){
+bool Interpreter::isEqual(const Object& a, const Object& b){
+    // ropes are flattened (and thus interned) before comparison
+    if (a.isString() && b.isString())
+        return LoxRope::flatten(a) == LoxRope::flatten(b);
     if (a.type != b.type) return false;
     switch(a.type){
         case Object::NIL:
@@ -338,13 +643,12 @@ bool Interpreter::isEqual(Object a, Object b){
             return a.literalBool == b.literalBool;
         case Object::NUMBER:
             return a.literalNumber == b.literalNumber;
-        case Object::STRING:
-            return a.literalString == b.literalString;
         default:
-            throw "UNIMPLEMENTED object type for isEqual!";    // Unreachable.
+            // callables, classes and instances compare by identity
+            return a.obj == b.obj;
     }
 }
 
-LoxError::RuntimeError Interpreter::error(Token token, std::string message){
+LoxError::RuntimeError Interpreter::error(const Token& token, std::string message){
     return LoxError::RuntimeError(token, message);
 }
\ No newline at end of file
@@ -3,69 +3,150 @@
 #include "stmt.hpp"
 #include "loxOutput.hpp"
 
-// requires Environments (support for variables and scope)
-#include "environment.hpp"
-
 // requires LoxCallables (support for functions, classes and methods)
 #include "loxCallable.hpp"
 #include "loxFunction.hpp"
 #include "loxClass.hpp"
 
+// requires LoxStrings for string concatenation and comparison
+#include "loxString.hpp"
+
 // requires Resolver for resolving and binding
 #include "resolver.hpp"
 
 #pragma once
 
-class Interpreter : public ExprVisitor, public StmtVisitor{
+struct Global{
+    // an entry of the global table
+    // constant: declared exactly once, by 'fun' or 'class' (or native), and never assigned to
+    Object value;
+    bool defined = false;
+    bool constant = false;
+    bool assigned = false;
+    int declarations = 0;
+};
+
+enum class Completion : std::uint8_t{
+    // how a statement completed. RETURN unwinds every enclosing statement up to the call,
+    // which takes the value from Interpreter::returnValue
+    // TAIL_CALL unwinds the same way, and the call then runs Interpreter::tailCallee
+    // with Interpreter::tailArguments in the same frame (see LoxFunction::call)
+    NORMAL, RETURN, TAIL_CALL
+};
+
+class Interpreter : public ExprVisitor<Object>, public StmtVisitor<Completion>{
     // Interprets an AST via the Visitor design pattern.
-    // Expressions return objects; Statements return void.
+    // Expressions return objects; Statements return how they completed.
     public:
         Interpreter(void);
-        Object evaluate(std::shared_ptr<Expr> expr);
-        std::any visit(std::shared_ptr<Expr> curr) override;
-        void execute(std::shared_ptr<Stmt> stmt);
-        void execute(std::vector<std::shared_ptr<Stmt>> statements);
-        std::any visit(std::shared_ptr<Stmt> curr) override;
+        using ExprVisitor<Object>::visit;
+        using StmtVisitor<Completion>::visit;
+        Object evaluate(Expr* expr);
+        Completion execute(Stmt* stmt);
+        Completion execute(std::vector<Stmt*>& statements);
+        void interpret(std::vector<Stmt*>& statements, int frameSize);
+        void interpret(StmtCode* program, int frameSize);
 
         // EXPR CHILD CLASSES
-        std::any visitLiteralExpr(std::shared_ptr<LiteralExpr> curr) override;
-        std::any visitGroupingExpr(std::shared_ptr<GroupingExpr> curr) override;
-        std::any visitUnaryExpr(std::shared_ptr<UnaryExpr> curr) override;
-        std::any visitBinaryExpr(std::shared_ptr<BinaryExpr> curr) override;
+        Object visitLiteralExpr(LiteralExpr* curr) override;
+        Object visitGroupingExpr(GroupingExpr* curr) override;
+        Object visitUnaryExpr(UnaryExpr* curr) override;
+        Object visitBinaryExpr(BinaryExpr* curr) override;
         
-        std::any visitVariableExpr(std::shared_ptr<VariableExpr> curr) override;
-        std::any visitAssignExpr(std::shared_ptr<AssignExpr> curr) override;
-        std::any visitLogicalExpr(std::shared_ptr<LogicalExpr> curr) override;
+        Object visitVariableExpr(VariableExpr* curr) override;
+        Object visitAssignExpr(AssignExpr* curr) override;
+        Object visitLogicalExpr(LogicalExpr* curr) override;
 
-        std::any visitCallExpr(std::shared_ptr<CallExpr> curr) override;
-        std::any visitGetExpr(std::shared_ptr<GetExpr> curr) override;
-        std::any visitSetExpr(std::shared_ptr<SetExpr> curr) override;
-        std::any visitThisExpr(std::shared_ptr<ThisExpr> curr) override;
-        std::any visitSuperExpr(std::shared_ptr<SuperExpr> curr) override;
+        Object visitCallExpr(CallExpr* curr) override;
+        Object visitGetExpr(GetExpr* curr) override;
+        Object visitSetExpr(SetExpr* curr) override;
+        Object visitThisExpr(ThisExpr* curr) override;
+        Object visitSuperExpr(SuperExpr* curr) override;
 
         // STMT CHILD CLASSES
-        std::any visitExpressionStmt(std::shared_ptr<ExpressionStmt> curr) override;
-        std::any visitPrintStmt(std::shared_ptr<PrintStmt> curr) override;
-        std::any visitVarStmt(std::shared_ptr<VarStmt> curr) override;
-        std::any visitBlockStmt(std::shared_ptr<BlockStmt> curr) override;
+        Completion visitExpressionStmt(ExpressionStmt* curr) override;
+        Completion visitPrintStmt(PrintStmt* curr) override;
+        Completion visitVarStmt(VarStmt* curr) override;
+        Completion visitBlockStmt(BlockStmt* curr) override;
         
-        std::any visitIfStmt(std::shared_ptr<IfStmt> curr) override;
-        std::any visitWhileStmt(std::shared_ptr<WhileStmt> curr) override;
+        Completion visitIfStmt(IfStmt* curr) override;
+        Completion visitWhileStmt(WhileStmt* curr) override;
+
+        Completion visitFunctionStmt(FunctionStmt* curr) override;
+        Completion visitReturnStmt(ReturnStmt* curr) override;
+        Completion visitClassStmt(ClassStmt* curr) override;
+
+        // globals are kept apart from local scopes. they are indexed by the slot the Resolver
+        // assigned to their name, and may be redefined (eg. in the REPL)
+        std::vector<Global> globals;
+        std::unordered_map<std::string, int> globalSlots;
+        // incremented whenever a global stops being constant, invalidating cached reads
+        unsigned globalEpoch = 1;
+        // locals live in frames on a single value stack, one frame per active call
+        // (top-level blocks use the frame of the program itself).
+        // [frameBase] is slot 0 of the current frame; [closure] is the function being called,
+        // holding the upvalues of the current frame (nullptr in top-level code)
+        std::vector<Object> stack;
+        size_t frameBase = 0;
+        LoxFunction* closure = nullptr;
+        // value of the 'return' being completed
+        Object returnValue;
+        // function and arguments of the tail call being completed
+        // ('this' of a method invoked in tail position, see returnInvoke).
+        // the buffer of the arguments is reused from one tail call to the next
+        Ref<LoxFunction> tailCallee;
+        Ref<LoxInstance> tailReceiver;
+        std::vector<Object> tailArguments;
+        LoxError::RuntimeError error(const Token& op, std::string message);
+
+        Object lookUpVariable(const Token& name, const VariableSlot& slot);
+        void defineVariable(const VariableSlot& slot, Object value);
+        Object& localVariable(const VariableSlot& slot);
+        std::vector<Ref<LoxUpvalue>> captureUpvalues(FunctionStmt& function);
 
-        std::any visitFunctionStmt(std::shared_ptr<FunctionStmt> curr) override;
-        std::any visitReturnStmt(std::shared_ptr<ReturnStmt> curr) override;
-        std::any visitClassStmt(std::shared_ptr<ClassStmt> curr) override;
+        // global table, used by the Resolver
+        int globalSlot(const std::string& name);
+        int declareGlobal(const std::string& name, bool constant);
+        void assignedGlobal(int slot);
 
-        std::shared_ptr<Environment> globals;
-        std::shared_ptr<Environment> env;
-        void executeBlock(std::vector<std::shared_ptr<Stmt>>& statements, std::shared_ptr<Environment> env);
-        LoxError::RuntimeError error(Token op, std::string message);
+        void defineGlobal(int slot, Object value);
+        Object& getGlobal(const Token& name, int slot);
+        void assignGlobal(const Token& name, int slot, Object value);
 
-        void resolve(std::shared_ptr<Expr> expr, int steps);
-        Object lookUpVariable(Token name, std::shared_ptr<Expr> expr);
+        // the work of expressions and statements on values already evaluated
+        // (shared with the StacklessInterpreter, which evaluates the operands itself)
+        Object unary(const Token& op, const Object& obj);
+        Object binary(const Token& op, const Object& left, const Object& right);
+        // the same, quickened: the node specialises itself on its first evaluation
+        Object unary(UnaryExpr* curr, const Object& obj);
+        Object binary(BinaryExpr* curr, const Object& left, const Object& right);
+        void assign(AssignExpr* curr, const Object& obj);
+        Object globalVariable(VariableExpr* curr);
+        // checks that [callee] can be called with [arguments]. the callee last checked
+        // at the call site is cached there, and needs no checks (see CallCache)
+        LoxCallable* checkCall(CallExpr* curr, const Object& callee, size_t arguments){
+            if (curr->cache.hit(callee)) return curr->cache.callee.as<LoxCallable>();
+            return checkCallSlow(curr, callee, arguments);
+        }
+        Object call(CallExpr* curr, const Object& callee, std::span<Object> arguments);
+        Completion returnCall(CallExpr* curr, const Object& callee, std::span<Object> arguments);
+        Object getProperty(GetExpr* curr, const Object& obj);
+        // 'obj.name(...)' calls the method of obj directly, without binding it first.
+        // invokedMethod returns nullptr if the property is not a method: it is then called
+        // as the value getProperty returns (a field, or an error)
+        LoxFunction* invokedMethod(GetExpr* curr, const Object& obj);
+        Object invoke(CallExpr* curr, LoxFunction* method, const Object& obj, std::span<Object> arguments);
+        Completion returnInvoke(CallExpr* curr, LoxFunction* method, const Object& obj, std::span<Object> arguments);
+        void checkInstance(SetExpr* curr, const Object& obj);
+        void setProperty(SetExpr* curr, const Object& obj, const Object& value);
+        void print(Object obj);
+        bool isTruthy(const Object& obj);
+        bool isEqual(const Object& a, const Object& b);
 
     private:
-        std::unordered_map<std::shared_ptr<Expr>, int> locals;
-        bool isTruthy(Object obj);
-        bool isEqual(Object a, Object b);
+        Completion tailCall(CallExpr* curr);
+        LoxCallable* checkCallSlow(CallExpr* curr, const Object& callee, size_t arguments);
+        void checkInvoke(CallExpr* curr, LoxFunction* method, size_t arguments);
+        static UnaryExpr::Specialization specialize(const Token& op, const Object& obj);
+        static BinaryExpr::Specialization specialize(const Token& op, const Object& left, const Object& right);
 };
\ No newline at end of file
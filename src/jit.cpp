@@ -0,0 +1,534 @@
+#include "jit.hpp"
+// requires LoxFunction, to check what a recursive call refers to
+#include "loxFunction.hpp"
+
+// machine code is only emitted for x86-64 Linux (System V calling convention, mmap)
+#if defined(__x86_64__) && defined(__linux__)
+#define LOX_JIT 1
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstring>
+#include <initializer_list>
+#endif
+
+bool Jit::enabled = true;
+unsigned Jit::threshold = Jit::defaultThreshold;
+std::uintptr_t Jit::stackLimit = 0;
+std::vector<std::unique_ptr<JitCode>> Jit::compiled = {};
+
+#ifdef LOX_JIT
+
+namespace{
+
+class Assembler{
+    // Machine code being emitted. Jumps may target labels bound later: their 32-bit
+    // displacements are patched by link()
+    public:
+        using Label = size_t;
+        // condition codes of Jcc
+        enum Condition : std::uint8_t { B = 0x2, AE = 0x3, E = 0x4, NE = 0x5, BE = 0x6, A = 0x7, P = 0xA };
+        std::vector<std::uint8_t> code = {};
+
+        Label label(void){
+            labels.push_back(SIZE_MAX);
+            return labels.size() - 1;
+        }
+        void bind(Label label){ labels[label] = code.size(); }
+
+        void bytes(std::initializer_list<std::uint8_t> values){ code.insert(code.end(), values); }
+        void imm32(std::int32_t value){
+            for (int i = 0; i < 4; i++) code.push_back((std::uint32_t)value >> (8 * i) & 0xFF);
+        }
+        void imm64(std::uint64_t value){
+            for (int i = 0; i < 8; i++) code.push_back(value >> (8 * i) & 0xFF);
+        }
+
+        void jmp(Label target){ jump({0xE9}, target); }
+        void jcc(Condition condition, Label target){ jump({0x0F, (std::uint8_t)(0x80 | condition)}, target); }
+        void call(Label target){ jump({0xE8}, target); }
+
+        void link(void){
+            for (auto [at, target] : fixups){
+                const std::int32_t displacement = (std::int32_t)(labels[target] - (at + 4));
+                std::memcpy(&code[at], &displacement, 4);
+            }
+        }
+
+    private:
+        std::vector<size_t> labels = {};
+        std::vector<std::pair<size_t, Label>> fixups = {};
+
+        void jump(std::initializer_list<std::uint8_t> opcode, Label target){
+            bytes(opcode);
+            fixups.push_back({code.size(), target});
+            imm32(0);
+        }
+};
+
+class JitCompiler{
+    // Checks that a function is numeric (see Jit), and emits its machine code.
+    // Doubles are computed in xmm0 (and xmm1, the right operand); temporaries are pushed
+    // on the native stack. Locals live at [rbp - 8 * (slot + 1)].
+    public:
+        using Label = Assembler::Label;
+        FunctionStmt* function;
+        Assembler as;
+        int selfSlot = -1;
+
+        JitCompiler(FunctionStmt* function) : function(function) {}
+
+        bool supported(void){
+            if (function->isMethod || !function->upvalues.empty()) return false;
+            for (const VariableSlot& slot : function->paramSlots)
+                if (slot.kind != VariableSlot::LOCAL) return false;
+            for (Stmt* statement : function->body)
+                if (!supported(statement)) return false;
+            return true;
+        }
+
+        void compile(void){
+            // entry point, callable from C++: int entry(const double* arguments, double* result)
+            body = as.label();
+            bail = as.label();
+            done = as.label();
+            as.bytes({0x53});                                   // push rbx
+            as.bytes({0x48, 0x89, 0xF3});                       // mov rbx, rsi
+            as.call(body);
+            as.bytes({0xF2, 0x0F, 0x11, 0x03});                 // movsd [rbx], xmm0
+            as.bytes({0x5B, 0xC3});                             // pop rbx; ret
+
+            // the function: arguments at [rdi], last first. returns its result in xmm0,
+            // and 0 in eax (1 if it bailed out)
+            as.bind(body);
+            as.bytes({0x55, 0x48, 0x89, 0xE5});                 // push rbp; mov rbp, rsp
+            as.bytes({0x48, 0x81, 0xEC});                       // sub rsp, frame
+            as.imm32(8 * function->frameSize);
+            as.bytes({0x48, 0xB8});                             // mov rax, &Jit::stackLimit
+            as.imm64((std::uint64_t)&Jit::stackLimit);
+            as.bytes({0x48, 0x3B, 0x20});                       // cmp rsp, [rax]
+            as.jcc(Assembler::B, bail);
+            const size_t arity = function->params.size();
+            for (size_t i = 0; i < arity; i++){
+                as.bytes({0xF2, 0x0F, 0x10, 0x87});             // movsd xmm0, [rdi + argument]
+                as.imm32((std::int32_t)(8 * (arity - 1 - i)));
+                store(function->paramSlots[i]);
+            }
+            start = as.label();
+            as.bind(start);
+            for (Stmt* statement : function->body) execute(statement);
+            // falling off the end returns nil
+            as.jmp(bail);
+
+            as.bind(bail);
+            as.bytes({0xB8, 0x01, 0x00, 0x00, 0x00});           // mov eax, 1
+            as.bytes({0xC9, 0xC3});                             // leave; ret
+            as.bind(done);
+            as.bytes({0x31, 0xC0});                             // xor eax, eax
+            as.bytes({0xC9, 0xC3});                             // leave; ret
+            as.link();
+        }
+
+    private:
+        Label body = 0, bail = 0, done = 0, start = 0;
+
+        // ---CHECKS---
+        bool isSelfCall(Expr* curr){
+            if (curr->type != Expr::CALL) return false;
+            CallExpr* call = static_cast<CallExpr*>(curr);
+            if (call->callee->type != Expr::VARIABLE) return false;
+            const VariableSlot& callee = static_cast<VariableExpr*>(call->callee)->slot;
+            return function->slot.kind == VariableSlot::GLOBAL && callee.kind == VariableSlot::GLOBAL
+                && callee.index == function->slot.index && call->arguments.size() == function->params.size();
+        }
+        bool numeric(Expr* curr){
+            // true if [curr] always evaluates to a number
+            switch (curr->type){
+                case Expr::LITERAL:
+                    return static_cast<LiteralExpr*>(curr)->obj.type == Object::NUMBER;
+                case Expr::GROUPING:
+                    return numeric(static_cast<GroupingExpr*>(curr)->expr);
+                case Expr::UNARY:{
+                    UnaryExpr* unary = static_cast<UnaryExpr*>(curr);
+                    return unary->op.type == Token::MINUS && numeric(unary->expr);
+                }
+                case Expr::BINARY:{
+                    BinaryExpr* binary = static_cast<BinaryExpr*>(curr);
+                    switch (binary->op.type){
+                        case Token::PLUS: case Token::MINUS: case Token::STAR: case Token::SLASH:
+                            return numeric(binary->left) && numeric(binary->right);
+                        default:
+                            return false;
+                    }
+                }
+                case Expr::VARIABLE:
+                    return static_cast<VariableExpr*>(curr)->slot.kind == VariableSlot::LOCAL;
+                case Expr::ASSIGN:{
+                    AssignExpr* assign = static_cast<AssignExpr*>(curr);
+                    return assign->slot.kind == VariableSlot::LOCAL && numeric(assign->expr);
+                }
+                case Expr::CALL:{
+                    if (!isSelfCall(curr)) return false;
+                    for (Expr* argument : static_cast<CallExpr*>(curr)->arguments)
+                        if (!numeric(argument)) return false;
+                    selfSlot = function->slot.index;
+                    return true;
+                }
+                default:
+                    return false;
+            }
+        }
+        bool condition(Expr* curr){
+            // true if [curr] always evaluates to a boolean, computed from numbers
+            switch (curr->type){
+                case Expr::LITERAL:
+                    return static_cast<LiteralExpr*>(curr)->obj.type == Object::BOOL;
+                case Expr::GROUPING:
+                    return condition(static_cast<GroupingExpr*>(curr)->expr);
+                case Expr::UNARY:{
+                    UnaryExpr* unary = static_cast<UnaryExpr*>(curr);
+                    return unary->op.type == Token::BANG && condition(unary->expr);
+                }
+                case Expr::BINARY:{
+                    BinaryExpr* binary = static_cast<BinaryExpr*>(curr);
+                    switch (binary->op.type){
+                        case Token::GREATER: case Token::GREATER_EQUAL: case Token::LESS: case Token::LESS_EQUAL:
+                        case Token::EQUAL_EQUAL: case Token::BANG_EQUAL:
+                            return numeric(binary->left) && numeric(binary->right);
+                        default:
+                            return false;
+                    }
+                }
+                case Expr::LOGICAL:{
+                    LogicalExpr* logical = static_cast<LogicalExpr*>(curr);
+                    return condition(logical->left) && condition(logical->right);
+                }
+                default:
+                    return false;
+            }
+        }
+        bool supported(Stmt* curr){
+            switch (curr->type){
+                case Stmt::EXPRESSION:
+                    return numeric(static_cast<ExpressionStmt*>(curr)->expr);
+                case Stmt::VAR:{
+                    VarStmt* var = static_cast<VarStmt*>(curr);
+                    return var->slot.kind == VariableSlot::LOCAL && var->initializer && numeric(var->initializer);
+                }
+                case Stmt::BLOCK:
+                    for (Stmt* statement : static_cast<BlockStmt*>(curr)->statements)
+                        if (!supported(statement)) return false;
+                    return true;
+                case Stmt::IF:{
+                    IfStmt* branch = static_cast<IfStmt*>(curr);
+                    return condition(branch->condition) && supported(branch->thenBranch)
+                        && (!branch->elseBranch || supported(branch->elseBranch));
+                }
+                case Stmt::WHILE:{
+                    WhileStmt* loop = static_cast<WhileStmt*>(curr);
+                    return condition(loop->condition) && supported(loop->body);
+                }
+                case Stmt::RETURN:{
+                    ReturnStmt* ret = static_cast<ReturnStmt*>(curr);
+                    return ret->expr && numeric(ret->expr);
+                }
+                default:
+                    return false;
+            }
+        }
+
+        // ---CODE---
+        static std::int32_t offset(const VariableSlot& slot){ return -8 * (slot.index + 1); }
+        void load(const VariableSlot& slot){
+            as.bytes({0xF2, 0x0F, 0x10, 0x85});                 // movsd xmm0, [rbp + slot]
+            as.imm32(offset(slot));
+        }
+        void store(const VariableSlot& slot){
+            as.bytes({0xF2, 0x0F, 0x11, 0x85});                 // movsd [rbp + slot], xmm0
+            as.imm32(offset(slot));
+        }
+        void constant(double value, bool right = false){
+            std::uint64_t bits;
+            std::memcpy(&bits, &value, 8);
+            as.bytes({0x48, 0xB8});                             // mov rax, bits
+            as.imm64(bits);
+            as.bytes({0x66, 0x48, 0x0F, 0x6E, (std::uint8_t)(right ? 0xC8 : 0xC0)});     // movq xmm0/1, rax
+        }
+        void push(void){
+            as.bytes({0x48, 0x83, 0xEC, 0x08});                 // sub rsp, 8
+            as.bytes({0xF2, 0x0F, 0x11, 0x04, 0x24});           // movsd [rsp], xmm0
+        }
+        void pop(void){
+            as.bytes({0xF2, 0x0F, 0x10, 0x04, 0x24});           // movsd xmm0, [rsp]
+            as.bytes({0x48, 0x83, 0xC4, 0x08});                 // add rsp, 8
+        }
+
+        static Expr* ungroup(Expr* curr){
+            while (curr->type == Expr::GROUPING) curr = static_cast<GroupingExpr*>(curr)->expr;
+            return curr;
+        }
+        void operands(Expr* left, Expr* right){
+            // left in xmm0, right in xmm1. literals and locals are loaded straight into xmm1
+            expression(left);
+            right = ungroup(right);
+            if (right->type == Expr::LITERAL){
+                constant(static_cast<LiteralExpr*>(right)->obj.literalNumber, true);
+                return;
+            }
+            if (right->type == Expr::VARIABLE){
+                as.bytes({0xF2, 0x0F, 0x10, 0x8D});             // movsd xmm1, [rbp + slot]
+                as.imm32(offset(static_cast<VariableExpr*>(right)->slot));
+                return;
+            }
+            push();
+            expression(right);
+            as.bytes({0x66, 0x0F, 0x28, 0xC8});                 // movapd xmm1, xmm0
+            pop();
+        }
+        void arguments(CallExpr* curr){
+            // pushed first to last: the callee finds them at [rdi], last first
+            for (Expr* argument : curr->arguments){
+                expression(argument);
+                push();
+            }
+        }
+
+        void expression(Expr* curr){
+            // evaluates a numeric expression into xmm0
+            switch (curr->type){
+                case Expr::LITERAL:
+                    constant(static_cast<LiteralExpr*>(curr)->obj.literalNumber);
+                    break;
+                case Expr::GROUPING:
+                    expression(static_cast<GroupingExpr*>(curr)->expr);
+                    break;
+                case Expr::UNARY:
+                    expression(static_cast<UnaryExpr*>(curr)->expr);
+                    constant(-0.0, true);
+                    as.bytes({0x66, 0x0F, 0x57, 0xC1});         // xorpd xmm0, xmm1 (flips the sign)
+                    break;
+                case Expr::BINARY:{
+                    BinaryExpr* binary = static_cast<BinaryExpr*>(curr);
+                    operands(binary->left, binary->right);
+                    std::uint8_t opcode;
+                    switch (binary->op.type){
+                        case Token::PLUS: opcode = 0x58; break;
+                        case Token::MINUS: opcode = 0x5C; break;
+                        case Token::STAR: opcode = 0x59; break;
+                        default: opcode = 0x5E; break;
+                    }
+                    as.bytes({0xF2, 0x0F, opcode, 0xC1});       // addsd/subsd/mulsd/divsd xmm0, xmm1
+                    break;
+                }
+                case Expr::VARIABLE:
+                    load(static_cast<VariableExpr*>(curr)->slot);
+                    break;
+                case Expr::ASSIGN:{
+                    AssignExpr* assign = static_cast<AssignExpr*>(curr);
+                    expression(assign->expr);
+                    store(assign->slot);
+                    break;
+                }
+                default:{
+                    // a call to the function itself
+                    CallExpr* call = static_cast<CallExpr*>(curr);
+                    arguments(call);
+                    as.bytes({0x48, 0x89, 0xE7});               // mov rdi, rsp
+                    as.call(body);
+                    as.bytes({0x48, 0x81, 0xC4});               // add rsp, arguments
+                    as.imm32((std::int32_t)(8 * call->arguments.size()));
+                    as.bytes({0x85, 0xC0});                     // test eax, eax
+                    as.jcc(Assembler::NE, bail);
+                    break;
+                }
+            }
+        }
+
+        void branch(Expr* curr, bool when, Label target){
+            // jumps to [target] if the condition [curr] evaluates to [when]
+            switch (curr->type){
+                case Expr::LITERAL:
+                    if (static_cast<LiteralExpr*>(curr)->obj.literalBool == when) as.jmp(target);
+                    break;
+                case Expr::GROUPING:
+                    branch(static_cast<GroupingExpr*>(curr)->expr, when, target);
+                    break;
+                case Expr::UNARY:
+                    branch(static_cast<UnaryExpr*>(curr)->expr, !when, target);
+                    break;
+                case Expr::LOGICAL:{
+                    // 'and' jumps on the first false operand, 'or' on the first true one
+                    LogicalExpr* logical = static_cast<LogicalExpr*>(curr);
+                    const bool shortCircuit = logical->op.type == Token::OR;
+                    if (when == shortCircuit){
+                        branch(logical->left, when, target);
+                        branch(logical->right, when, target);
+                    }
+                    else{
+                        const Label skip = as.label();
+                        branch(logical->left, shortCircuit, skip);
+                        branch(logical->right, when, target);
+                        as.bind(skip);
+                    }
+                    break;
+                }
+                default:{
+                    // comparisons are false if either operand is NaN (unordered), except '!='
+                    BinaryExpr* binary = static_cast<BinaryExpr*>(curr);
+                    operands(binary->left, binary->right);
+                    const Token::TokenType op = binary->op.type;
+                    if (op == Token::EQUAL_EQUAL || op == Token::BANG_EQUAL){
+                        as.bytes({0x66, 0x0F, 0x2E, 0xC1});     // ucomisd xmm0, xmm1
+                        if (when == (op == Token::BANG_EQUAL)){
+                            as.jcc(Assembler::P, target);
+                            as.jcc(Assembler::NE, target);
+                        }
+                        else{
+                            const Label skip = as.label();
+                            as.jcc(Assembler::P, skip);
+                            as.jcc(Assembler::E, target);
+                            as.bind(skip);
+                        }
+                        break;
+                    }
+                    // 'a < b' is compared as 'b > a', so that unordered operands are always false
+                    if (op == Token::GREATER || op == Token::GREATER_EQUAL)
+                        as.bytes({0x66, 0x0F, 0x2E, 0xC1});     // ucomisd xmm0, xmm1
+                    else
+                        as.bytes({0x66, 0x0F, 0x2E, 0xC8});     // ucomisd xmm1, xmm0
+                    const bool strict = op == Token::GREATER || op == Token::LESS;
+                    if (when) as.jcc(strict ? Assembler::A : Assembler::AE, target);
+                    else as.jcc(strict ? Assembler::BE : Assembler::B, target);
+                    break;
+                }
+            }
+        }
+
+        void execute(Stmt* curr){
+            switch (curr->type){
+                case Stmt::EXPRESSION:
+                    expression(static_cast<ExpressionStmt*>(curr)->expr);
+                    break;
+                case Stmt::VAR:{
+                    VarStmt* var = static_cast<VarStmt*>(curr);
+                    expression(var->initializer);
+                    store(var->slot);
+                    break;
+                }
+                case Stmt::BLOCK:
+                    for (Stmt* statement : static_cast<BlockStmt*>(curr)->statements) execute(statement);
+                    break;
+                case Stmt::IF:{
+                    IfStmt* ifStmt = static_cast<IfStmt*>(curr);
+                    const Label elseBranch = as.label();
+                    branch(ifStmt->condition, false, elseBranch);
+                    execute(ifStmt->thenBranch);
+                    if (ifStmt->elseBranch){
+                        const Label end = as.label();
+                        as.jmp(end);
+                        as.bind(elseBranch);
+                        execute(ifStmt->elseBranch);
+                        as.bind(end);
+                    }
+                    else as.bind(elseBranch);
+                    break;
+                }
+                case Stmt::WHILE:{
+                    WhileStmt* loop = static_cast<WhileStmt*>(curr);
+                    const Label top = as.label(), end = as.label();
+                    as.bind(top);
+                    branch(loop->condition, false, end);
+                    execute(loop->body);
+                    as.jmp(top);
+                    as.bind(end);
+                    break;
+                }
+                default:{
+                    ReturnStmt* ret = static_cast<ReturnStmt*>(curr);
+                    if (ret->tailCall && isSelfCall(ret->tailCall)){
+                        // a tail call to itself reuses the frame: the arguments replace the
+                        // parameters, and the body starts over
+                        arguments(ret->tailCall);
+                        for (size_t i = function->params.size(); i-- > 0;){
+                            pop();
+                            store(function->paramSlots[i]);
+                        }
+                        as.jmp(start);
+                        break;
+                    }
+                    expression(ret->expr);
+                    as.jmp(done);
+                    break;
+                }
+            }
+        }
+};
+
+}
+
+JitCode::~JitCode(void){
+    munmap(pages, size);
+}
+
+JitCode* Jit::compile(FunctionStmt* function){
+    JitCompiler compiler(function);
+    if (!compiler.supported()) return nullptr;
+    compiler.compile();
+
+    // write the code, then make its pages executable (and no longer writable)
+    const std::vector<std::uint8_t>& code = compiler.as.code;
+    const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    const size_t size = (code.size() + pageSize - 1) / pageSize * pageSize;
+    void* pages = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pages == MAP_FAILED) return nullptr;
+    std::memcpy(pages, code.data(), code.size());
+    if (mprotect(pages, size, PROT_READ | PROT_EXEC) != 0){
+        munmap(pages, size);
+        return nullptr;
+    }
+
+    compiled.push_back(std::make_unique<JitCode>(pages, size));
+    JitCode* jit = compiled.back().get();
+    jit->entry = reinterpret_cast<JitCode::Entry>(pages);
+    jit->selfSlot = compiler.selfSlot;
+    return jit;
+}
+
+#else
+
+JitCode::~JitCode(void) {}
+
+JitCode* Jit::compile(FunctionStmt* function){
+    return nullptr;
+}
+
+#endif
+
+bool Jit::run(JitCode* code, FunctionStmt* function, Interpreter& interpreter,
+    std::span<const Object> arguments, Object& result){
+    if (code->bailed) return false;
+    // the body calls itself through a global: it must still hold this function
+    if (code->selfSlot >= 0){
+        const Object& self = interpreter.globals[code->selfSlot].value;
+        if (self.type != Object::LOX_CALLABLE) return false;
+        LoxFunction* callee = self.as<LoxCallable>()->function();
+        if (!callee || callee->declaration != function) return false;
+    }
+    // arguments are unboxed, last first
+    const size_t arity = arguments.size();
+    double values[256];
+    for (size_t i = 0; i < arity; i++){
+        if (arguments[i].type != Object::NUMBER) return false;
+        values[arity - 1 - i] = arguments[i].literalNumber;
+    }
+
+    // the native stack grows down from here
+    const std::uintptr_t here = (std::uintptr_t)&values;
+    stackLimit = here > maxStack ? here - maxStack : 0;
+    double value;
+    if (code->entry(values, &value) != 0){
+        code->bailed = true;
+        return false;
+    }
+    result = Object::number(value);
+    return true;
+}
@@ -0,0 +1,70 @@
+// requires the declarations being compiled, and the values they are called with
+#include "stmt.hpp"
+#include "expr.hpp"
+// requires the global table, to check what a recursive call refers to
+#include "interpreter.hpp"
+// required for the compiled code
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#pragma once
+
+class JitCode{
+    // The machine code of one function, in its own executable pages (see Jit).
+    public:
+        // entry point: arguments are passed last-first, the result is written to [result].
+        // returns 0, or 1 if the code bailed out
+        using Entry = int (*)(const double* arguments, double* result);
+        Entry entry = nullptr;
+        // global slot of the function, if its body calls itself through it (-1 otherwise)
+        int selfSlot = -1;
+        // set once the code has bailed out: calls are left to the tree walker from then on
+        bool bailed = false;
+
+        JitCode(void* pages, size_t size) : pages(pages), size(size) {}
+        ~JitCode(void);
+        JitCode(const JitCode&) = delete;
+        JitCode& operator=(const JitCode&) = delete;
+    private:
+        void* pages;
+        size_t size;
+};
+
+class Jit{
+    // Baseline JIT for hot numeric functions: once a function has been called [threshold] times,
+    // its body is compiled to x86-64 machine code, which later calls run instead of the tree walker.
+    /*
+        KEY NOTES:
+        1. Only pure numeric functions are compiled: their bodies use nothing but parameters and
+           locals (in frame slots, not captured), number literals, arithmetic, comparisons and
+           logical operators in conditions, 'var', assignment, 'if', 'while', 'return' of a number,
+           and calls to the function itself through its global name. Anything else (print,
+           strings, globals, closures, classes) leaves the function to the tree walker.
+        2. Values are unboxed doubles: locals live in the native frame, arithmetic is SSE2.
+           The entry guards check that every argument is a number, and that the global the body
+           calls is still this function; if not, the call is left to the tree walker.
+        3. The code bails out where it cannot produce a number: falling off the end of the
+           body (nil), or recursing too deep for the native stack. As the function is pure,
+           the call is then simply run again by the tree walker, and the code is not used again.
+        4. x86-64 Linux only (System V calling convention, mmap). Elsewhere nothing is compiled.
+    */
+    public:
+        static bool enabled;
+        static unsigned threshold;
+        static constexpr unsigned defaultThreshold = 100;
+
+        // compiles [function], or returns nullptr if its body is not numeric
+        static JitCode* compile(FunctionStmt* function);
+        // runs [code] for a call. returns false if the call must be run by the tree walker instead
+        static bool run(JitCode* code, FunctionStmt* function, Interpreter& interpreter,
+            std::span<const Object> arguments, Object& result);
+
+        // lowest native stack address compiled code may use before bailing out
+        static std::uintptr_t stackLimit;
+        static constexpr std::uintptr_t maxStack = 1 << 20;
+    private:
+        // compiled code lives as long as the program (compiled functions are always retained)
+        static std::vector<std::unique_ptr<JitCode>> compiled;
+};
@@ -5,6 +5,11 @@
 bool Lox::hasCompileError = false;
 bool Lox::hasRuntimeError = false;
 Interpreter Lox::interpreter;
+StacklessInterpreter Lox::stackless(Lox::interpreter);
+VM Lox::vm(Lox::interpreter);
+Lox::Engine Lox::engine = Lox::Engine::TREE;
+size_t Lox::maxDepth = StacklessInterpreter::defaultMaxDepth;
+std::vector<std::unique_ptr<AstArena>> Lox::programs;
 
 void Lox::run(std::string source, bool parseExpr){
     Lox::hasCompileError = false;
@@ -17,12 +22,17 @@ void Lox::run(std::string source, bool parseExpr){
         return;
     }
 
-    StmtParser parser(tokens);
-    std::vector<std::shared_ptr<Stmt>> statements = parser.parse(parseExpr);
+    // the arena owns the tokens and the AST. it is freed on return,
+    // unless the program declared functions, which may outlive this run
+    std::unique_ptr<AstArena> arena = std::make_unique<AstArena>(std::move(tokens));
+    StmtParser parser(*arena);
+    std::vector<Stmt*> statements = parser.parse(parseExpr);
     if (parser.hasError){
         hasCompileError = true;
         return;
     }
+    AstArena& program = *arena;
+    if (arena->hasFunctions) programs.push_back(std::move(arena));
 
     // ASTPrinter printer;
     // for (auto stmt : statements) std::cerr << printer.print(stmt) << "\n";
@@ -35,7 +45,24 @@ void Lox::run(std::string source, bool parseExpr){
     }
 
     try{
-        interpreter.execute(statements);
+        if (engine == Engine::STACKLESS){
+            stackless.maxDepth = maxDepth;
+            stackless.interpret(statements, resolver.frameSize());
+        }
+        else if (engine == Engine::CLOSURE){
+            ClosureCompiler compiler(program);
+            interpreter.interpret(compiler.compile(statements), resolver.frameSize());
+        }
+        else if (engine == Engine::FLAT){
+            FlatCompiler compiler(program);
+            interpreter.interpret(compiler.compile(statements), resolver.frameSize());
+        }
+        else if (engine == Engine::VM){
+            BytecodeCompiler compiler(program);
+            vm.maxDepth = maxDepth;
+            vm.interpret(compiler.compile(statements, resolver.frameSize()), resolver.frameSize());
+        }
+        else interpreter.interpret(statements, resolver.frameSize());
     }
     catch (LoxError::RuntimeError err){
         err.print();
@@ -44,6 +71,33 @@ void Lox::run(std::string source, bool parseExpr){
     }
 }
 
+void Lox::compile(std::string source, std::ostream& out){
+    Lox::hasCompileError = false;
+
+    Scanner scanner(source);
+    std::vector<Token> tokens = scanner.scan();
+    if (scanner.hasError){
+        hasCompileError = true;
+        return;
+    }
+    AstArena arena(std::move(tokens));
+    StmtParser parser(arena);
+    std::vector<Stmt*> statements = parser.parse();
+    if (parser.hasError){
+        hasCompileError = true;
+        return;
+    }
+    // resolved against a fresh global table, as the compiled program is (see CompiledProgram)
+    Interpreter globals;
+    Resolver resolver(globals);
+    resolver.resolve(statements);
+    if (resolver.hasError){
+        hasCompileError = true;
+        return;
+    }
+    out << CppCompiler(statements).compile(source);
+}
+
 static inline void replInfo(void){
     // Helper function for Lox REPL session.
     std::cout << "To exit, type 'exit'. For multiline input, toggle 'multiline'.\n";
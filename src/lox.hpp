@@ -2,6 +2,15 @@
 #include "scanner.hpp"
 #include "stmtParser.hpp"
 #include "interpreter.hpp"
+#include "stacklessInterpreter.hpp"
+#include "closureCompiler.hpp"
+#include "flatCompiler.hpp"
+#include "bytecodeCompiler.hpp"
+#include "vm.hpp"
+#include "cppCompiler.hpp"
+// required for retaining programs that declared functions
+#include <memory>
+#include <vector>
 
 #pragma once
 
@@ -10,8 +19,22 @@ class Lox{
     // as described in the Lox standard
     private:
         static Interpreter interpreter;
+        static StacklessInterpreter stackless;
+        static VM vm;
+        // programs whose functions may still be called (eg. from a later REPL line)
+        static std::vector<std::unique_ptr<AstArena>> programs;
     public:
+        // how programs are executed: by recursing over the AST,
+        // by StacklessInterpreter (with at most [maxDepth] nested calls),
+        // by compiling them with ClosureCompiler first, by lowering them to a FlatAst first,
+        // or by compiling them to bytecode for the VM (also with at most [maxDepth] nested calls)
+        enum class Engine { TREE, STACKLESS, CLOSURE, FLAT, VM };
+        static Engine engine;
+        static size_t maxDepth;
+
         static void run(std::string source, bool parseExpr = false);
+        // writes the program [source] to [out], compiled to C++ (see CppCompiler)
+        static void compile(std::string source, std::ostream& out);
         static void repl(void);
         static bool hasCompileError;
         static bool hasRuntimeError;
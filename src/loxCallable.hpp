@@ -2,25 +2,59 @@
 
 // requires access to system clock for clock()
 #include <chrono>
+// required for the arguments of calls
+#include <memory>
+#include <span>
+#include <vector>
 
 #pragma once
 
 // Interpreter not included: only declaration required
 class Interpreter;
+class LoxFunction;
 
-class LoxCallable{
+class LoxCallable : public LoxObject{
     // Abstract class implementing the l-value (locator value) of a callable Lox object type
+    // [arguments] are owned by the caller, who does not use them after the call: a callee
+    // may move them out. They must not live in Interpreter::stack, which a call may grow
+    // (native functions excepted, which do not call back into Lox).
     public:
-        virtual ~LoxCallable(void) = default;
         virtual int arity(void) = 0;
-        virtual Object call(Interpreter& interpreter, std::vector<Object>& arguments) = 0;
-        virtual std::string toString(void) = 0;
+        virtual Object call(Interpreter& interpreter, std::span<Object> arguments) = 0;
+        // the user-defined function, if this is one (tail calls only replace those)
+        virtual LoxFunction* function(void) { return nullptr; }
+};
+
+class ArgumentBuffer{
+    // The arguments of a call, evaluated by the caller before calling with span().
+    // Up to [inlineSize] arguments are stored inline, on the native stack of the caller;
+    // only calls with more allocate.
+    public:
+        static constexpr size_t inlineSize = 4;
+        ArgumentBuffer(size_t count) : count(count) {
+            if (count > inlineSize) overflow.resize(count);
+            else std::uninitialized_default_construct_n(slots(), count);
+        }
+        ~ArgumentBuffer(void){ if (count <= inlineSize) std::destroy_n(slots(), count); }
+        ArgumentBuffer(const ArgumentBuffer&) = delete;
+        ArgumentBuffer& operator=(const ArgumentBuffer&) = delete;
+
+        Object& operator[](size_t i){ return data()[i]; }
+        Object* data(void){ return count > inlineSize ? overflow.data() : slots(); }
+        size_t size(void) const { return count; }
+        std::span<Object> span(void){ return {data(), count}; }
+
+    private:
+        size_t count;
+        alignas(Object) unsigned char storage[inlineSize * sizeof(Object)];
+        std::vector<Object> overflow = {};
+        Object* slots(void){ return reinterpret_cast<Object*>(storage); }
 };
 
 class Clock : public LoxCallable{
     public:
     int arity(void) override { return 0; }
-    Object call(Interpreter& interpreter, std::vector<Object>& arguments) override{
+    Object call(Interpreter& interpreter, std::span<Object> arguments) override{
         using namespace std::chrono;
         return Object::number(
             duration<double>(duration_cast<seconds>( system_clock::now().time_since_epoch() )).count()
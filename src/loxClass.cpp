@@ -2,45 +2,83 @@
 // requires actual Interpreter
 #include "interpreter.hpp"
 
-int LoxClass::arity(){
-    std::shared_ptr<LoxFunction> initializer = findMethod("init");
-    if (initializer) return initializer->arity();
-    else return 0;
+LoxClass::LoxClass(std::string name, Ref<LoxClass> superclass,
+    std::unordered_map<std::string, Ref<LoxFunction>> methods) :
+    name(name), superclass(superclass), methods(std::move(methods)){
+    // inherit every method not overridden. the superclass's table is already flattened
+    if (superclass)
+        for (auto& [methodName, method] : superclass->methods) this->methods.insert({methodName, method});
+    initializer = findMethod("init");
+    initArity = initializer ? initializer->arity() : 0;
+    Heap::track(this);
 }
 std::string LoxClass::toString(){
     return name;
 }
-Object LoxClass::call(Interpreter& interpreter, std::vector<Object>& arguments){
-    std::shared_ptr<LoxInstance> instance = std::make_shared<LoxInstance>(shared_from_this());
-    std::shared_ptr<LoxFunction> initializer = findMethod("init");
+Object LoxClass::call(Interpreter& interpreter, std::span<Object> arguments){
+    Ref<LoxInstance> instance = makeRef<LoxInstance>(this);
+    // the initializer runs with the new instance as 'this', without being bound to it
     if (initializer)
-        initializer->bind(instance)->call(interpreter, arguments);
+        initializer->call(interpreter, arguments, instance.get());
 
     return Object::instance(instance);
 }
-std::shared_ptr<LoxFunction> LoxClass::findMethod(std::string s){
-    // finds and returns method in class. return nullptr if it doesn't exist.
-    if (methods.count(s)) return methods.at(s);
-    if (superclass) return superclass->findMethod(s);
-    else return nullptr;
+Ref<LoxFunction> LoxClass::findMethod(const std::string& s){
+    // finds and returns method in class (or inherited). return nullptr if it doesn't exist.
+    auto it = methods.find(s);
+    return it == methods.end() ? nullptr : it->second;
+}
+
+void LoxClass::traverse(HeapVisitor& visitor){
+    if (superclass) visitor.visit(superclass.get());
+    for (auto& [name, method] : methods) visitor.visit(method.get());
+    if (initializer) visitor.visit(initializer.get());
+}
+void LoxClass::clearReferences(){
+    superclass = nullptr;
+    methods.clear();
+    initializer = nullptr;
 }
 
 
 std::string LoxInstance::toString(){
     return loxClass->toString() + " instance";
 }
-Object LoxInstance::get(Token& name){
+Object LoxInstance::getSlow(const Token& name, PropertyCache& cache){
     // get the property of name [name] 
     // can be field (instance-based) or method (class-based)
-    // fields shadow methods
-    if (fields.count(name.lexeme)) return fields.at(name.lexeme);
+    // fields shadow methods. only fields are cached
+    const int slot = shape->find(name.lexeme);
+    if (slot >= 0){
+        cache.add(shape, shape, slot);
+        return fields[slot];
+    }
 
-    std::shared_ptr<LoxFunction> func = loxClass->findMethod(name.lexeme);
-    if (func) return Object::function(func->bind(shared_from_this()));
+    Ref<LoxFunction> func = loxClass->findMethod(name.lexeme);
+    if (func) return Object::function(func->bind(this));
 
     throw LoxError::RuntimeError(name, "Undefined property '" + name.lexeme + "'.");
 }
-void LoxInstance::set(Token& name, Object value){
+void LoxInstance::setSlow(const Token& name, Object value, PropertyCache& cache){
     // no checking if field exists, as Lox permits addition of fields.
-    fields[name.lexeme] = value;
+    // a new field moves the instance to the next shape, and is cached as that transition
+    const int slot = shape->find(name.lexeme);
+    if (slot >= 0){
+        cache.add(shape, shape, slot);
+        fields[slot] = std::move(value);
+        return;
+    }
+    Shape* next = shape->add(name.lexeme);
+    cache.add(shape, next, (std::uint32_t)fields.size());
+    fields.push_back(std::move(value));
+    shape = next;
+}
+void LoxInstance::traverse(HeapVisitor& visitor){
+    if (loxClass) visitor.visit(loxClass.get());
+    for (Object& value : fields) value.trace(visitor);
+}
+void LoxInstance::clearReferences(){
+    loxClass = nullptr;
+    fields.clear();
+    shape = Shape::empty();
 }
\ No newline at end of file
@@ -1,31 +1,72 @@
 // inherits forward declaration of Interpreter
 #include "loxCallable.hpp"
 #include "loxFunction.hpp"
+// fields are laid out by shape, and accessed through the inline caches of expressions
+#include "shape.hpp"
 
 #pragma once
 
-class LoxClass : public LoxCallable, public std::enable_shared_from_this<LoxClass>{
+class LoxClass : public LoxCallable{
+    // [methods] is flattened when the class is defined: it holds the inherited methods too
+    // (overridden ones excepted), so looking up a method is a single lookup however deep
+    // the hierarchy. The initializer, and the arity of calls to the class, are cached with it.
     public:
         std::string name;
-        std::shared_ptr<LoxClass> superclass;
-        std::unordered_map<std::string, std::shared_ptr<LoxFunction>> methods;
-        LoxClass(std::string name, std::shared_ptr<LoxClass> superclass, 
-            std::unordered_map<std::string, std::shared_ptr<LoxFunction>> methods) :
-            name(name), superclass(superclass), methods(methods) {}
+        Ref<LoxClass> superclass;
+        std::unordered_map<std::string, Ref<LoxFunction>> methods;
+        Ref<LoxFunction> initializer;
+        LoxClass(std::string name, Ref<LoxClass> superclass, 
+            std::unordered_map<std::string, Ref<LoxFunction>> methods);
 
-        int arity(void) override;
-        Object call(Interpreter& interpreter, std::vector<Object>& arguments) override;
-        std::string toString(void);
-        std::shared_ptr<LoxFunction> findMethod(std::string s);
+        int arity(void) override { return initArity; }
+        Object call(Interpreter& interpreter, std::span<Object> arguments) override;
+        std::string toString(void) override;
+        Ref<LoxFunction> findMethod(const std::string& s);
+
+        void traverse(HeapVisitor& visitor) override;
+        void clearReferences(void) override;
+    private:
+        int initArity = 0;
 };
 
-class LoxInstance : public std::enable_shared_from_this<LoxInstance>{
+class LoxInstance : public LoxObject{
+    // Fields are stored densely, in the slots their Shape assigns.
+    // Accesses through a PropertyCache that has seen the shape are an indexed load (or store).
     public:
-        std::shared_ptr<LoxClass> loxClass;
-        LoxInstance(std::shared_ptr<LoxClass> loxClass) : loxClass(loxClass) {}
-        std::string toString(void);
-        Object get(Token& name);
-        void set(Token& name, Object value);
+        Ref<LoxClass> loxClass;
+        LoxInstance(Ref<LoxClass> loxClass) : loxClass(loxClass) { Heap::track(this); }
+        std::string toString(void) override;
+        Object get(const Token& name, PropertyCache& cache){
+            for (int i = 0; i < cache.count; i++)
+                if (cache.shapes[i] == shape) return fields[cache.slots[i]];
+            return getSlow(name, cache);
+        }
+        void set(const Token& name, Object value, PropertyCache& cache){
+            for (int i = 0; i < cache.count; i++){
+                if (cache.shapes[i] != shape) continue;
+                if (cache.next[i] == shape) fields[cache.slots[i]] = std::move(value);
+                else{
+                    fields.push_back(std::move(value));
+                    shape = cache.next[i];
+                }
+                return;
+            }
+            setSlow(name, std::move(value), cache);
+        }
+        // the method invoked by 'instance.name(...)', unbound. nullptr if a field shadows it
+        // (cached accesses are fields) or there is no such method
+        LoxFunction* method(const Token& name, const PropertyCache& cache){
+            for (int i = 0; i < cache.count; i++)
+                if (cache.shapes[i] == shape) return nullptr;
+            if (shape->find(name.lexeme) >= 0) return nullptr;
+            return loxClass->findMethod(name.lexeme).get();
+        }
+
+        void traverse(HeapVisitor& visitor) override;
+        void clearReferences(void) override;
     private:
-        std::unordered_map<std::string, Object> fields = {};
+        Shape* shape = Shape::empty();
+        std::vector<Object> fields = {};
+        Object getSlow(const Token& name, PropertyCache& cache);
+        void setSlow(const Token& name, Object value, PropertyCache& cache);
 };
\ No newline at end of file
@@ -3,39 +3,99 @@
 #include "interpreter.hpp"
 // requires LoxInstance
 #include "loxClass.hpp"
+// requires compiled function bodies
+#include "closureCompiler.hpp"
+// requires machine code of hot numeric functions
+#include "jit.hpp"
 
 int LoxFunction::arity(){
     return (int)declaration->params.size();
 }
 
-Object LoxFunction::call(Interpreter& interpreter, std::vector<Object>& arguments){
-    // create new scope and define all arguments
-    std::shared_ptr<Environment> env = std::make_shared<Environment>(closure);
-    for (int i = 0; i < declaration->params.size(); i++){
-        env->define(declaration->params[i].lexeme, arguments[i]);
+Object LoxFunction::call(Interpreter& interpreter, std::span<Object> arguments, LoxInstance* instance){
+    // hot numeric functions run as machine code, unless a guard fails (see Jit)
+    if (Jit::enabled){
+        if (declaration->jit){
+            Object result = Object::nil();
+            if (Jit::run(declaration->jit, declaration, interpreter, arguments, result)) return result;
+        }
+        else if (++declaration->calls == Jit::threshold) declaration->jit = Jit::compile(declaration);
     }
 
-    // try execute block. if return value caught, save it
+    // push a frame for the call, and define 'this' (for methods) and all arguments in it
+    // the frame also holds every other local of the body, in the slots the Resolver assigned
+    const size_t base = interpreter.stack.size();
+    const size_t prevBase = interpreter.frameBase;
+    LoxFunction* const prevClosure = interpreter.closure;
+
+    // the function running in the frame. a tail call replaces it (and its arguments),
+    // and runs in the same frame instead of a nested call
+    Ref<LoxFunction> function = this;
+    Ref<LoxInstance> receiver = instance;
+    std::span<Object> args = arguments;
+
+    // execute block. if it completed with a return, take the value returned
     // if isInitializer, return 'this' (LoxInstance)
-    // else return either object thrown or Object::NIL
+    // else return either the value returned or Object::NIL
     // (the Resolver prevents values being returned from initializers)
+    // if a RuntimeError is thrown, pop the frame before rethrowing
     Object obj = Object::nil();
     try{
-        interpreter.executeBlock(declaration->body, env);
+        while (true){
+            FunctionStmt* const declaration = function->declaration;
+            interpreter.stack.resize(base + declaration->frameSize);
+            interpreter.frameBase = base;
+            interpreter.closure = function.get();
+
+            if (declaration->isMethod)
+                interpreter.defineVariable(declaration->thisSlot, Object::instance(receiver));
+            for (size_t i = 0; i < declaration->params.size(); i++)
+                interpreter.defineVariable(declaration->paramSlots[i], std::move(args[i]));
+
+            const Completion completion = declaration->code ?
+                (*declaration->code)(interpreter) : interpreter.execute(declaration->body);
+            if (completion == Completion::TAIL_CALL){
+                // clear the frame for the callee. its arguments are moved out of
+                // Interpreter::tailArguments, whose buffer is reused by the next tail call
+                function = std::move(interpreter.tailCallee);
+                receiver = interpreter.tailReceiver ? std::move(interpreter.tailReceiver) : function->receiver;
+                args = interpreter.tailArguments;
+                interpreter.stack.resize(base);
+                continue;
+            }
+            if (completion == Completion::RETURN){
+                obj = std::move(interpreter.returnValue);
+                interpreter.returnValue = Object::nil();
+            }
+            break;
+        }
     }
-    catch (LoxReturn val){
-        obj = val.obj;
+    catch (...){
+        interpreter.frameBase = prevBase;
+        interpreter.closure = prevClosure;
+        interpreter.stack.resize(base);
+        throw;
     }
-    return isInitializer ? closure->getAt(0, "this") : obj;
+    interpreter.frameBase = prevBase;
+    interpreter.closure = prevClosure;
+    interpreter.stack.resize(base);
+    return function->isInitializer ? Object::instance(receiver) : obj;
 }
 
 std::string LoxFunction::toString(){
     return "<fn " + declaration->name.lexeme + ">";
 }
 
-std::shared_ptr<LoxFunction> LoxFunction::bind(std::shared_ptr<LoxInstance> instance){
+Ref<LoxFunction> LoxFunction::bind(Ref<LoxInstance> instance){
     // returns a new function with 'this' keyword binded to instance
-    std::shared_ptr<Environment> env = std::make_shared<Environment>(closure);
-    env->define("this", Object::instance(instance));
-    return std::make_shared<LoxFunction>(declaration, env, isInitializer);
-}
\ No newline at end of file
+    return makeRef<LoxFunction>(declaration, upvalues, isInitializer, instance);
+}
+
+void LoxFunction::traverse(HeapVisitor& visitor){
+    for (Ref<LoxUpvalue>& upvalue : upvalues) visitor.visit(upvalue.get());
+    if (receiver) visitor.visit(receiver.get());
+}
+void LoxFunction::clearReferences(){
+    upvalues.clear();
+    receiver = nullptr;
+}
@@ -1,26 +1,54 @@
 // innherits forward declaration of Interpreter
 #include "loxCallable.hpp"
 #include "stmt.hpp"
-#include "environment.hpp"
+// closures and upvalues are heap objects, tracked by the collector
+#include "heap.hpp"
 
 #pragma once
 
 // forward declaration of LoxInstance
 class LoxInstance;
 
+class LoxUpvalue : public LoxObject{
+    // The box of a local variable captured by a closure.
+    // Only captured variables are boxed (see VariableSlot::BOXED): the declaring frame holds
+    // the box in the variable's slot, and every closure capturing it holds the same box,
+    // so the variable outlives the call that declared it.
+    public:
+        Object value;
+        LoxUpvalue(Object value) : value(value) { Heap::track(this); }
+        std::string toString(void) override { return "<upvalue>"; }
+
+        void traverse(HeapVisitor& visitor) override { value.trace(visitor); }
+        void clearReferences(void) override { value = Object::nil(); }
+};
+
 class LoxFunction : public LoxCallable{
     // Runtime representation of user-defined Lox function
     // Wrapper for Function : Stmt
+    // A flat closure: holds only the variables its body captures, not the enclosing scopes.
     public:
-        std::shared_ptr<FunctionStmt> declaration;
-        std::shared_ptr<Environment> closure;
+        FunctionStmt* declaration;
+        std::vector<Ref<LoxUpvalue>> upvalues;
         bool isInitializer;
-        LoxFunction(std::shared_ptr<FunctionStmt> declaration, std::shared_ptr<Environment> closure, bool isInitializer = false) : 
-            declaration(declaration), closure(closure), isInitializer(isInitializer) {}
+        // 'this' of a bound method. nullptr for functions and unbound methods
+        Ref<LoxInstance> receiver;
+        LoxFunction(FunctionStmt* declaration, std::vector<Ref<LoxUpvalue>> upvalues,
+            bool isInitializer = false, Ref<LoxInstance> receiver = nullptr) : 
+            declaration(declaration), upvalues(std::move(upvalues)), 
+            isInitializer(isInitializer), receiver(receiver) { Heap::track(this); }
 
         int arity(void) override;
-        Object call(Interpreter& interpreter, std::vector<Object>& arguments) override;
+        Object call(Interpreter& interpreter, std::span<Object> arguments) override {
+            return call(interpreter, arguments, receiver.get());
+        }
+        // calls a method with [instance] as 'this', without binding it (see Interpreter::invoke)
+        Object call(Interpreter& interpreter, std::span<Object> arguments, LoxInstance* instance);
+        LoxFunction* function(void) override { return this; }
         std::string toString(void) override;
+
+        void traverse(HeapVisitor& visitor) override;
+        void clearReferences(void) override;
         
-        std::shared_ptr<LoxFunction> bind(std::shared_ptr<LoxInstance> instance);
-};
\ No newline at end of file
+        Ref<LoxFunction> bind(Ref<LoxInstance> instance);
+};
@@ -0,0 +1,103 @@
+// requires strings for toString
+#include <string>
+// required for std::forward in makeRef
+#include <utility>
+// required for fixed-width integers
+#include <cstdint>
+#include <cstddef>
+
+#pragma once
+
+/*
+    HEADER FILES SHOUD DECLARE:
+        PUBLIC variables
+        PUBLIC functions
+        PUBLIC classes
+            This includes public and private variables,
+            public and private functions,
+            and main and delegated constructors.
+    Declarations include variable names, functions and their parameters.
+*/
+
+class LoxObject;
+
+class HeapVisitor{
+    // Abstract class implementing the Visitor design pattern for references between heap objects.
+    // Used by the cycle collector (see Heap) to walk the object graph.
+    public:
+        virtual ~HeapVisitor(void) = default;
+        virtual void visit(LoxObject* obj) = 0;
+};
+
+class LoxObject{
+    // Abstract base class of every heap-allocated Lox value
+    // (strings, callables, classes and instances) and of captured variables (LoxUpvalue).
+    // Reference counted intrusively: a handle to a LoxObject is a single raw pointer,
+    // which keeps Object at 16 bytes (tag + 8-byte payload).
+    // The interpreter is single-threaded, so the count is a plain integer, not an atomic.
+    // Reference counting frees acyclic garbage immediately; cycles are left to Heap,
+    // which traces every object that can hold references (a "container").
+    public:
+        int refCount = 0;
+        virtual ~LoxObject(void);
+        virtual std::string toString(void) = 0;
+
+        void retain(void){ refCount++; }
+        void release(void){ if (--refCount == 0) delete this; }
+
+        // all LoxObjects are allocated through Heap, which may collect beforehand
+        static void* operator new(size_t size);
+        static void operator delete(void* ptr, size_t size);
+
+        // containers override both: traverse() visits every LoxObject held,
+        // clearReferences() drops them (used to break garbage cycles)
+        virtual void traverse(HeapVisitor& visitor) {}
+        virtual void clearReferences(void) {}
+
+        // bookkeeping for Heap. do not modify outside of Heap
+        enum class GCState : std::uint8_t {
+            UNTRACKED, YOUNG, OLD, COLLECTING, REACHABLE
+        };
+        GCState gcState = GCState::UNTRACKED;
+        int gcRefs = 0;
+        LoxObject* gcPrev = nullptr;
+        LoxObject* gcNext = nullptr;
+};
+
+template<typename T>
+class Ref{
+    // Intrusive smart pointer to a LoxObject subclass.
+    // Stands in for std::shared_ptr: no separate control block, no atomic increments.
+    // A Ref may be constructed from a raw pointer at any time (eg. from 'this'),
+    // as the reference count lives in the object itself.
+    public:
+        Ref(void) : ptr(nullptr) {}
+        Ref(std::nullptr_t) : ptr(nullptr) {}
+        Ref(T* ptr) : ptr(ptr) { if (ptr) ptr->retain(); }
+        Ref(const Ref& other) : ptr(other.ptr) { if (ptr) ptr->retain(); }
+        Ref(Ref&& other) noexcept : ptr(other.ptr) { other.ptr = nullptr; }
+        template<typename U>
+        Ref(const Ref<U>& other) : ptr(other.get()) { if (ptr) ptr->retain(); }
+        ~Ref(void){ if (ptr) ptr->release(); }
+
+        Ref& operator=(Ref other){
+            // copy-and-swap: handles self-assignment and both copy and move
+            std::swap(ptr, other.ptr);
+            return *this;
+        }
+
+        T* get(void) const { return ptr; }
+        T* operator->(void) const { return ptr; }
+        T& operator*(void) const { return *ptr; }
+        explicit operator bool(void) const { return ptr != nullptr; }
+        bool operator==(const Ref& other) const { return ptr == other.ptr; }
+
+    private:
+        T* ptr;
+};
+
+template<typename T, typename... Args>
+Ref<T> makeRef(Args&&... args){
+    // counterpart of std::make_shared for LoxObjects
+    return Ref<T>(new T(std::forward<Args>(args)...));
+}
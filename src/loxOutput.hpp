@@ -40,11 +40,4 @@ class LoxError{
             std::cerr << "[line " << token.line << "] Error at '" << token.lexeme << "': " << message << "\n";
         }
     };
-};
-
-class LoxReturn{
-    // Wrapper class for returning an object from a function.
-    public:
-    Object obj;
-    LoxReturn(Object obj) : obj(obj) {}
 };
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "loxString.hpp"
+
+LoxString::InternTable& LoxString::table(void){
+    // allocated once and never destroyed:
+    // strings held by static objects may be released after static destruction begins
+    static InternTable* strings = new InternTable();
+    return *strings;
+}
+
+Ref<LoxString> LoxString::intern(std::string chars){
+    // returns the existing string with these contents, if any.
+    // otherwise creates one and records it in the intern table.
+    std::uint32_t hash = hashString(chars);
+    InternTable& strings = table();
+    auto it = strings.find(Key{chars, hash});
+    if (it != strings.end()) return Ref<LoxString>(*it);
+
+    LoxString* str = new LoxString(std::move(chars), hash);
+    strings.insert(str);
+    return Ref<LoxString>(str);
+}
+
+LoxString::~LoxString(void){
+    table().erase(this);
+}
+
+std::uint32_t LoxString::hashString(std::string_view chars){
+    // FNV-1a, as used by the sister bytecode interpreter
+    std::uint32_t hash = 2166136261u;
+    for (char c : chars){
+        hash ^= (std::uint8_t)c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+
+Ref<LoxString> LoxRope::flatten(void){
+    if (!flat) flat = LoxString::intern(std::string(view()));
+    return flat;
+}
+
+Object LoxRope::concat(const Object& left, const Object& right){
+    // view of the right operand's characters
+    std::string_view rightChars = right.type == Object::ROPE ?
+        right.as<LoxRope>()->view() : std::string_view(right.as<LoxString>()->chars);
+
+    // append in place if no other rope has extended the left operand's buffer yet
+    if (left.type == Object::ROPE){
+        LoxRope* rope = left.as<LoxRope>();
+        if (rope->buffer->size() == rope->length){
+            if (right.type == Object::ROPE && right.as<LoxRope>()->buffer == rope->buffer){
+                // eg. s + s: copy before appending, as the view aliases the buffer
+                std::string copy(rightChars);
+                rope->buffer->append(copy);
+            }
+            else rope->buffer->append(rightChars);
+            return Object::rope(makeRef<LoxRope>(rope->buffer, rope->buffer->size()));
+        }
+    }
+
+    // otherwise, start a new buffer holding both operands
+    std::string_view leftChars = left.type == Object::ROPE ?
+        left.as<LoxRope>()->view() : std::string_view(left.as<LoxString>()->chars);
+    std::shared_ptr<std::string> buffer = std::make_shared<std::string>();
+    buffer->reserve(leftChars.size() + rightChars.size());
+    buffer->append(leftChars);
+    buffer->append(rightChars);
+    size_t length = buffer->size();
+    return Object::rope(makeRef<LoxRope>(buffer, length));
+}
+
+LoxString* LoxRope::flatten(const Object& str){
+    if (str.type == Object::ROPE) return str.as<LoxRope>()->flatten().get();
+    return str.as<LoxString>();
+}
@@ -0,0 +1,77 @@
+// requires the LoxObject base class, and Objects for concatenation
+#include "loxObject.hpp"
+#include "token.hpp"
+
+// required for the shared buffer of LoxRope
+#include <memory>
+
+// required for the intern table
+#include <cstdint>
+#include <string_view>
+#include <unordered_set>
+
+#pragma once
+
+class LoxString : public LoxObject{
+    // Runtime representation of a Lox string.
+    // Immutable and interned: equal strings share one LoxString,
+    // so string equality is a pointer comparison.
+    // Create strings through LoxString::intern() only.
+    public:
+        const std::string chars;
+        const std::uint32_t hash;
+        ~LoxString(void) override;
+        std::string toString(void) override { return chars; }
+
+        static Ref<LoxString> intern(std::string chars);
+        static std::uint32_t hashString(std::string_view chars);
+
+    private:
+        LoxString(std::string chars, std::uint32_t hash) : chars(std::move(chars)), hash(hash) {}
+
+        // key type for lookup without constructing a LoxString
+        struct Key{
+            std::string_view chars;
+            std::uint32_t hash;
+        };
+        struct KeyHash{
+            using is_transparent = void;
+            size_t operator()(const LoxString* s) const { return s->hash; }
+            size_t operator()(const Key& k) const { return k.hash; }
+        };
+        struct KeyEqual{
+            using is_transparent = void;
+            bool operator()(const LoxString* a, const LoxString* b) const { return a == b; }
+            bool operator()(const Key& k, const LoxString* s) const { return k.hash == s->hash && k.chars == s->chars; }
+            bool operator()(const LoxString* s, const Key& k) const { return k.hash == s->hash && k.chars == s->chars; }
+        };
+        using InternTable = std::unordered_set<LoxString*, KeyHash, KeyEqual>;
+        // the table does not own its strings: a string removes itself when released
+        static InternTable& table(void);
+};
+
+class LoxRope : public LoxObject{
+    // Runtime representation of a string built by concatenation ('+').
+    // Concatenation is lazy: a LoxRope is a prefix [0, length) of a buffer
+    // that may be shared with the ropes it was built from.
+    // If the left operand ends exactly at the end of its buffer, the right operand
+    // is appended to that buffer in place, so 's = s + x' in a loop is amortised linear.
+    // The rope is flattened into an interned LoxString on first observation
+    // (printing, equality), and the result is cached.
+    public:
+        LoxRope(std::shared_ptr<std::string> buffer, size_t length) : buffer(buffer), length(length) {}
+        std::string toString(void) override { return flatten()->chars; }
+
+        Ref<LoxString> flatten(void);
+        std::string_view view(void) const { return std::string_view(*buffer).substr(0, length); }
+
+        // concatenates two string Objects (STRING or ROPE) into a ROPE
+        static Object concat(const Object& left, const Object& right);
+        // returns the interned LoxString for a string Object (STRING or ROPE)
+        static LoxString* flatten(const Object& str);
+
+    private:
+        std::shared_ptr<std::string> buffer;
+        const size_t length;
+        Ref<LoxString> flat = nullptr;
+};
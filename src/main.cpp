@@ -16,36 +16,104 @@
 #include "stmtParser.hpp"
 #include "ASTPrinter.hpp"
 
+// garbage collector configuration and statistics
+#include "heap.hpp"
+// baseline JIT configuration
+#include "jit.hpp"
+
 std::string read_file_contents(const std::string& filename);
 
 static inline int usageInfo(){
     std::cerr << "Usage: ./lox.sh tokenize <filename>" << std::endl;
     std::cerr << "    |  ./lox.sh parse <filename>" << std::endl;
-    std::cerr << "    |  ./lox.sh evaluate <filename>" << std::endl;
-    std::cerr << "    |  ./lox.sh run <filename>" << std::endl;
-    std::cerr << "    |  ./lox.sh <filename>" << std::endl;
-    std::cerr << "    |  ./lox.sh" << std::endl;
+    std::cerr << "    |  ./lox.sh evaluate [options] <filename>" << std::endl;
+    std::cerr << "    |  ./lox.sh run [options] <filename>" << std::endl;
+    std::cerr << "    |  ./lox.sh compile <filename>" << std::endl;
+    std::cerr << "    |  ./lox.sh [options] <filename>" << std::endl;
+    std::cerr << "    |  ./lox.sh [options]" << std::endl;
+    std::cerr << "Options:" << std::endl;
+    std::cerr << "    --gc-stats                 Print garbage collector statistics on exit." << std::endl;
+    std::cerr << "    --gc-heap-min=<bytes>      Heap size below which no full collection runs." << std::endl;
+    std::cerr << "    --gc-heap-growth=<factor>  Heap growth since the last full collection that triggers the next." << std::endl;
+    std::cerr << "    --gc-young=<objects>       New objects between young-generation collections." << std::endl;
+    std::cerr << "    --pool-stats               Print allocation pool statistics on exit." << std::endl;
+    std::cerr << "    --engine=<name>            Execute by recursing over the AST (tree), with an explicit stack" << std::endl;
+    std::cerr << "                               (stackless), as compiled closures (closure), over a flattened AST" << std::endl;
+    std::cerr << "                               (flat), or as bytecode (vm)." << std::endl;
+    std::cerr << "    --max-depth=<frames>       Nested calls allowed by the stackless and vm engines." << std::endl;
+    std::cerr << "    --no-jit                   Never compile hot numeric functions to machine code." << std::endl;
+    std::cerr << "    --jit-threshold=<calls>    Calls after which a numeric function is compiled to machine code." << std::endl;
     return 1;
 }
 
+static bool gcStats = false;
+static bool poolStats = false;
+
+static bool parseOption(const std::string& arg){
+    // parses an option of the form --name or --name=value. returns false if invalid
+    size_t eq = arg.find('=');
+    std::string name = arg.substr(0, eq);
+    std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+    try{
+        if (name == "--gc-stats" && value.empty()) gcStats = true;
+        else if (name == "--gc-heap-min") Heap::config.heapMinimum = std::stoull(value);
+        else if (name == "--gc-heap-growth") Heap::config.heapGrowth = std::stod(value);
+        else if (name == "--gc-young") Heap::config.youngThreshold = std::stoull(value);
+        else if (name == "--pool-stats" && value.empty()) poolStats = true;
+        else if (name == "--engine" && value == "tree") Lox::engine = Lox::Engine::TREE;
+        else if (name == "--engine" && value == "stackless") Lox::engine = Lox::Engine::STACKLESS;
+        else if (name == "--engine" && value == "closure") Lox::engine = Lox::Engine::CLOSURE;
+        else if (name == "--engine" && value == "flat") Lox::engine = Lox::Engine::FLAT;
+        else if (name == "--engine" && value == "vm") Lox::engine = Lox::Engine::VM;
+        else if (name == "--max-depth" && std::stoull(value) > 0) Lox::maxDepth = std::stoull(value);
+        else if (name == "--no-jit" && value.empty()) Jit::enabled = false;
+        else if (name == "--jit-threshold" && std::stoul(value) > 0) Jit::threshold = std::stoul(value);
+        else return false;
+    }
+    catch (std::exception&){
+        return false;
+    }
+    return true;
+}
+
+static int finish(int code){
+    // exit hook for commands that execute Lox code
+    if (gcStats) Heap::printStats(std::cerr);
+    if (poolStats) Heap::printPoolStats(std::cerr);
+    return code;
+}
+
 int main(int argc, char *argv[]) {
     // Disable output buffering
     std::cout << std::unitbuf;
     std::cerr << std::unitbuf;
 
-    if (argc > 3) {
+    // split arguments into options and positional arguments
+    std::vector<std::string> args = {};
+    for (int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) == 0){
+            if (!parseOption(arg)){
+                std::cerr << "Unknown option: " << arg << std::endl;
+                return usageInfo();
+            }
+        }
+        else args.push_back(arg);
+    }
+
+    if (args.size() > 2) {
         return usageInfo();
     }
     std::string command;
     std::string filePath;
-    if (argc == 1) command = "repl";
+    if (args.size() == 0) command = "repl";
     else {
-        command = argv[1];
-        if (argc == 2){
+        command = args[0];
+        if (args.size() == 1){
             command = "run";
-            filePath = argv[1];
+            filePath = args[0];
         } else {
-            filePath = argv[2];
+            filePath = args[1];
         }
     }
 
@@ -65,8 +133,9 @@ int main(int argc, char *argv[]) {
         std::vector<Token> tokens = scanner.scan();
         if (scanner.hasError) return 65;
 
-        ExprParser parser(tokens);
-        std::shared_ptr<Expr> expr = parser.parse();
+        AstArena arena(std::move(tokens));
+        ExprParser parser(arena);
+        Expr* expr = parser.parse();
         if (parser.hasError) return 65;
 
         ASTPrinter printer;
@@ -78,20 +147,25 @@ int main(int argc, char *argv[]) {
     if (command == "evaluate"){
         std::string file_contents = read_file_contents(filePath);
         Lox::run(file_contents, true);
-        if (Lox::hasCompileError) return 65;
-        if (Lox::hasRuntimeError) return 70;
-        return 0;
+        if (Lox::hasCompileError) return finish(65);
+        if (Lox::hasRuntimeError) return finish(70);
+        return finish(0);
     }
     if (command == "run"){
         std::string file_contents = read_file_contents(filePath);
         Lox::run(file_contents);
-        if (Lox::hasCompileError) return 65;
-        if (Lox::hasRuntimeError) return 70;
-        return 0;
+        if (Lox::hasCompileError) return finish(65);
+        if (Lox::hasRuntimeError) return finish(70);
+        return finish(0);
+    }
+    if (command == "compile"){
+        std::string file_contents = read_file_contents(filePath);
+        Lox::compile(file_contents, std::cout);
+        return Lox::hasCompileError ? 65 : 0;
     }
     if (command == "repl"){
         Lox::repl();
-        return 0;
+        return finish(0);
     }
     
     else {
@@ -3,159 +3,165 @@
 // requires implemetation details of Interpreter
 // (previously declared separately)
 #include "interpreter.hpp"
+// required for std::max
+#include <algorithm>
 
 
 Resolver::Resolver(Interpreter& interpreter) : interpreter(interpreter){
     // interpreter has to be passed as member initializer
     hasError = false;
-    scopes = {};
+    // top-level code: its frame holds the variables of top-level blocks
+    functions = {};
+    functions.emplace_back();
     currentFunction = FunctionType::NONE;
     currentClass = ClassType::NONE;
 }
-void Resolver::resolve(std::shared_ptr<Expr> expr){
+void Resolver::resolve(Expr* expr){
     visit(expr);
 }
-std::any Resolver::visit(std::shared_ptr<Expr> curr){
-    return curr->accept(*this);
-}
-void Resolver::resolve(std::shared_ptr<Stmt> stmt){
+void Resolver::resolve(Stmt* stmt){
     visit(stmt);
 }
-void Resolver::resolve(std::vector<std::shared_ptr<Stmt>> statements){
-    for (std::shared_ptr<Stmt> stmt : statements)
+void Resolver::resolve(std::vector<Stmt*>& statements){
+    for (Stmt*& stmt : statements)
         resolve(stmt);
 }
-std::any Resolver::visit(std::shared_ptr<Stmt> curr){
-    return curr->accept(*this);
-}
 
 // EXPR CHILD CLASSES
-std::any Resolver::visitLiteralExpr(std::shared_ptr<LiteralExpr> curr){
+void Resolver::visitLiteralExpr(LiteralExpr* curr){
     // nothing to resolve
-    return nullptr;
+    return;
 }
-std::any Resolver::visitGroupingExpr(std::shared_ptr<GroupingExpr> curr){
+void Resolver::visitGroupingExpr(GroupingExpr* curr){
     resolve(curr->expr);
-    return nullptr;
+    return;
 }
-std::any Resolver::visitUnaryExpr(std::shared_ptr<UnaryExpr> curr){
+void Resolver::visitUnaryExpr(UnaryExpr* curr){
     resolve(curr->expr);
-    return nullptr;
+    return;
 }
-std::any Resolver::visitBinaryExpr(std::shared_ptr<BinaryExpr> curr){
+void Resolver::visitBinaryExpr(BinaryExpr* curr){
     resolve(curr->left);
     resolve(curr->right);
-    return nullptr;
+    return;
 }
 
-std::any Resolver::visitVariableExpr(std::shared_ptr<VariableExpr> curr){
+void Resolver::visitVariableExpr(VariableExpr* curr){
     // l-value of variable
     // eg. var a = a;
     // in this case, evaluating RHS leads to a being declared but not defined
     // an error is printed (not thrown) and execution will not proceed
     // otherwise, resolve local variable a
-    if (!scopes.empty() && scopes.back().count(curr->name.lexeme) && scopes.back().at(curr->name.lexeme) == false)
+    if (!scopes().empty() && scopes().back().locals.count(curr->name.lexeme) && 
+        scopes().back().locals.at(curr->name.lexeme).defined == false)
         error(curr->name, "Cannot read variable in its own initializer.").print();
     
-    resolveLocal(curr, curr->name);
-    return nullptr;
+    resolveLocal(curr->slot, curr->name);
+    return;
 }
-std::any Resolver::visitAssignExpr(std::shared_ptr<AssignExpr> curr){
+void Resolver::visitAssignExpr(AssignExpr* curr){
     // resolve nested expression. then, resolve the whole assignment as a local variable
+    // assigned globals can no longer be treated as constants
     resolve(curr->expr);
-    resolveLocal(curr, curr->name);
-    return nullptr;
+    resolveLocal(curr->slot, curr->name);
+    if (curr->slot.kind == VariableSlot::GLOBAL) interpreter.assignedGlobal(curr->slot.index);
+    return;
 }
-std::any Resolver::visitLogicalExpr(std::shared_ptr<LogicalExpr> curr){
+void Resolver::visitLogicalExpr(LogicalExpr* curr){
     // resolve expressions. no short-circuiting is done.
     resolve(curr->left);
     resolve(curr->right);
-    return nullptr;
+    return;
 }
 
-std::any Resolver::visitCallExpr(std::shared_ptr<CallExpr> curr){
+void Resolver::visitCallExpr(CallExpr* curr){
     resolve(curr->callee);
-    for (std::shared_ptr<Expr> arg : curr->arguments)
+    for (Expr* arg : curr->arguments)
         resolve(arg);
-    return nullptr;
+    return;
 }
-std::any Resolver::visitGetExpr(std::shared_ptr<GetExpr> curr){
+void Resolver::visitGetExpr(GetExpr* curr){
     resolve(curr->expr);
-    return nullptr;
+    return;
 }
-std::any Resolver::visitSetExpr(std::shared_ptr<SetExpr> curr){
+void Resolver::visitSetExpr(SetExpr* curr){
     resolve(curr->expr);
     resolve(curr->value);
-    return nullptr;
+    return;
 }
-std::any Resolver::visitThisExpr(std::shared_ptr<ThisExpr> curr){
+void Resolver::visitThisExpr(ThisExpr* curr){
     if (currentClass == ClassType::NONE){
         error(curr->keyword, "Cannot use 'this' outside a class.").print();
-        return nullptr;
+        return;
     }
-    resolveLocal(curr, curr->keyword);
-    return nullptr;
+    resolveLocal(curr->slot, curr->keyword);
+    return;
 }
-std::any Resolver::visitSuperExpr(std::shared_ptr<SuperExpr> curr){
+void Resolver::visitSuperExpr(SuperExpr* curr){
     if (currentClass == ClassType::NONE){
         error(curr->keyword, "Cannot use 'super' outside of a class.").print();
     }
     else if (currentClass == ClassType::CLASS){
         error(curr->keyword, "Cannot use 'super' in a class with no superclass.").print();
     }
-    resolveLocal(curr, curr->keyword);
-    return nullptr;
+    else {
+        resolveLocal(curr->slot, curr->keyword);
+        resolveLocal(curr->thisSlot, Token(Token::THIS, "this", Object::nil(), curr->keyword.line));
+    }
+    return;
 }
 
 
 // STMT CHILD CLASSES
-std::any Resolver::visitExpressionStmt(std::shared_ptr<ExpressionStmt> curr){
+void Resolver::visitExpressionStmt(ExpressionStmt* curr){
     resolve(curr->expr);
-    return nullptr;
+    return;
 }
-std::any Resolver::visitPrintStmt(std::shared_ptr<PrintStmt> curr){
+void Resolver::visitPrintStmt(PrintStmt* curr){
     resolve(curr->expr);
-    return nullptr;
+    return;
 }
-std::any Resolver::visitVarStmt(std::shared_ptr<VarStmt> curr){
+void Resolver::visitVarStmt(VarStmt* curr){
     // Variable declaration. Links with visitVariable(curr)
-    declare(curr->name);
+    if (scopes().empty()) curr->slot.index = interpreter.declareGlobal(curr->name.lexeme, false);
+    declare(curr->name, curr->slot);
     if (curr->initializer)
         resolve(curr->initializer);
     define(curr->name);
-    return nullptr;
+    return;
 }
-std::any Resolver::visitBlockStmt(std::shared_ptr<BlockStmt> curr){
+void Resolver::visitBlockStmt(BlockStmt* curr){
     // create and resolve in new topmost scope. pop when done.
     beginScope();
     resolve(curr->statements);
     endScope();
-    return nullptr;
+    return;
 }
 
-std::any Resolver::visitIfStmt(std::shared_ptr<IfStmt> curr){
+void Resolver::visitIfStmt(IfStmt* curr){
     // resolve all branches.
     resolve(curr->condition);
     resolve(curr->thenBranch);
     if (curr->elseBranch) 
         resolve(curr->elseBranch);
-    return nullptr;
+    return;
 }
-std::any Resolver::visitWhileStmt(std::shared_ptr<WhileStmt> curr){
+void Resolver::visitWhileStmt(WhileStmt* curr){
     resolve(curr->condition);
     resolve(curr->body);
-    return nullptr;
+    return;
 }
 
-std::any Resolver::visitFunctionStmt(std::shared_ptr<FunctionStmt> curr){
+void Resolver::visitFunctionStmt(FunctionStmt* curr){
     // resolve function name, then call helper method for arguments and body
     // resolveFunction will be reused for classes and methods
-    declare(curr->name);
+    if (scopes().empty()) curr->slot.index = interpreter.declareGlobal(curr->name.lexeme, true);
+    declare(curr->name, curr->slot);
     define(curr->name);
     resolveFunction(curr, FunctionType::FUNCTION);
-    return nullptr;
+    return;
 }
-std::any Resolver::visitReturnStmt(std::shared_ptr<ReturnStmt> curr){
+void Resolver::visitReturnStmt(ReturnStmt* curr){
     // resolve return expression
     // 'return' CANNOT show up in top-level code.
     // return cannot be non-NIL if in initializer
@@ -166,16 +172,23 @@ std::any Resolver::visitReturnStmt(std::shared_ptr<ReturnStmt> curr){
         if (currentFunction == FunctionType::INITIALIZER)
             error(curr->keyword, "Cannot return a value from initializer.").print();
         resolve(curr->expr);
+
+        // a call whose value is returned at once is a tail call:
+        // the interpreter runs it in the frame of the caller
+        Expr* expr = curr->expr;
+        while (expr->type == Expr::GROUPING) expr = static_cast<GroupingExpr*>(expr)->expr;
+        if (expr->type == Expr::CALL) curr->tailCall = static_cast<CallExpr*>(expr);
     }
-    return nullptr;
+    return;
 }
-std::any Resolver::visitClassStmt(std::shared_ptr<ClassStmt> curr){
+void Resolver::visitClassStmt(ClassStmt* curr){
     // declare and define class name
-    // then, in new scope, define this keyword and all methods
+    // then resolve all methods, which receive 'this' in their own frames
     const ClassType enclosingType = currentClass;
     currentClass = ClassType::CLASS;
 
-    declare(curr->name);
+    if (scopes().empty()) curr->slot.index = interpreter.declareGlobal(curr->name.lexeme, true);
+    declare(curr->name, curr->slot);
     define(curr->name);
     if (curr->superclass){
         if (curr->superclass->name.lexeme == curr->name.lexeme)
@@ -186,85 +199,151 @@ std::any Resolver::visitClassStmt(std::shared_ptr<ClassStmt> curr){
 
         // add 'super' for this class in an enclosing scope
         beginScope();
-        scopes.back().insert({"super", true});
+        Token super(Token::SUPER, "super", Object::nil(), curr->name.line);
+        declare(super, curr->superSlot);
+        define(super);
     }
 
-    beginScope();
-    scopes.back().insert({"this", true});
-    for (std::shared_ptr<FunctionStmt> func : curr->methods){
+    for (FunctionStmt* func : curr->methods){
         FunctionType type = FunctionType::METHOD;
         if (func->name.lexeme == "init")
             type = FunctionType::INITIALIZER;
         resolveFunction(func, type);
     }
-    endScope();
 
     // end enclosing scope if inheriting from superclass
     if (curr->superclass) endScope();
 
     currentClass = enclosingType;
 
-    return nullptr;
+    return;
 }
 
-LoxError::ParseError Resolver::error(Token token, std::string message){
+LoxError::ParseError Resolver::error(const Token& token, std::string message){
     hasError = true;
     return LoxError::ParseError(token, message);
 }
 
+int Resolver::frameSize(void){
+    return functions.front().frameSize;
+}
+
 // ---HELPER FUNCTIONS---
+std::deque<Resolver::Scope>& Resolver::scopes(void){
+    // scopes of the function being resolved. empty in top-level code outside of blocks
+    return functions.back().scopes;
+}
 void Resolver::beginScope(void){
     // create a new scope and push to stack
-    scopes.push_back(std::unordered_map<std::string, bool>());
+    scopes().push_back(Scope{{}, functions.back().nextSlot});
 }
 void Resolver::endScope(void){
-    // pop the scope at top of stack
-    scopes.pop_back();
+    // pop the scope at top of stack. its slots may be reused by later scopes
+    functions.back().nextSlot = scopes().back().firstSlot;
+    scopes().pop_back();
 }
-void Resolver::declare(Token name){
+void Resolver::declare(const Token& name, VariableSlot& slot){
     // declares a variable [name] in the topmost (current) scope by setting to false
+    // the variable takes the next free slot of the function's frame
     // redeclaration of local variable is a compilation error (DO NOT THROW)
     // redeclaration of global variable is not tracked by [scopes] and permitted
-    if (scopes.empty()) return;
-    if (scopes.back().count(name.lexeme))
+    if (scopes().empty()) return;
+    if (scopes().back().locals.count(name.lexeme))
         error(name, "Already a variable with this name in this scope.").print();
-    scopes.back().insert({name.lexeme, false});
+    FunctionScope& function = functions.back();
+    slot.kind = VariableSlot::LOCAL;
+    slot.index = function.nextSlot++;
+    function.frameSize = std::max(function.frameSize, function.nextSlot);
+    scopes().back().locals.insert({name.lexeme, Local{false, slot.index, false, {&slot}}});
 }
-void Resolver::define(Token name){
+void Resolver::define(const Token& name){
     // defines a variable [name] in the topmost (current) scope by setting to true
     // declaration and definition are coupled in Lox,
     // so accessing a variable that is declared but not defined is a compilation error (DO NOT THROW)
     // redefinition can only happen with redeclaration and is thus not permitted
     // reassignment is treated separately from redefinition.
-    if (scopes.empty()) return;
-    scopes.back().at(name.lexeme) = true;
-}
-void Resolver::resolveLocal(std::shared_ptr<Expr> expr, Token name){
-    // given a local variable [name], find the number of steps required
-    // to resolve the variable to its scope
-    // resolved variable are defined in its environment, evaluated line-by-line
-    // store result as hash table
-    for (int i = (int)scopes.size() - 1; i >= 0; i--){
-        if (scopes[i].count(name.lexeme)){
-            interpreter.resolve(expr, (int)scopes.size() - 1 - i);
+    if (scopes().empty()) return;
+    scopes().back().locals.at(name.lexeme).defined = true;
+}
+void Resolver::resolveLocal(VariableSlot& slot, const Token& name){
+    // given a variable [name], find where it is stored and record it in the node itself:
+    // a local of the current function, an upvalue captured from an enclosing function,
+    // or a global
+    std::deque<Scope>& current = scopes();
+    for (int i = (int)current.size() - 1; i >= 0; i--){
+        auto it = current[i].locals.find(name.lexeme);
+        if (it != current[i].locals.end()){
+            Local& local = it->second;
+            slot.kind = local.captured ? VariableSlot::BOXED : VariableSlot::LOCAL;
+            slot.index = local.slot;
+            local.nodes.push_back(&slot);
             return;
         }
     }
-    // variable exists in global scope. no resolution required.
+    int upvalue = resolveUpvalue((int)functions.size() - 1, name);
+    if (upvalue >= 0){
+        slot.kind = VariableSlot::UPVALUE;
+        slot.index = upvalue;
+        return;
+    }
+    // variable exists in global scope. resolve its name to an index in the global table
+    slot.kind = VariableSlot::GLOBAL;
+    slot.index = interpreter.globalSlot(name.lexeme);
+}
+int Resolver::resolveUpvalue(int function, const Token& name){
+    // finds [name] in the functions enclosing functions[function], innermost first.
+    // the local found is marked captured, and each function in between records an upvalue for it.
+    // returns the index of the upvalue in functions[function], or -1 for globals
+    if (function == 0) return -1;
+    std::deque<Scope>& enclosing = functions[function - 1].scopes;
+    for (int i = (int)enclosing.size() - 1; i >= 0; i--){
+        auto it = enclosing[i].locals.find(name.lexeme);
+        if (it != enclosing[i].locals.end()){
+            Local& local = it->second;
+            if (!local.captured){
+                local.captured = true;
+                for (VariableSlot* node : local.nodes) node->kind = VariableSlot::BOXED;
+            }
+            return addUpvalue(functions[function], true, local.slot);
+        }
+    }
+    int upvalue = resolveUpvalue(function - 1, name);
+    if (upvalue >= 0) return addUpvalue(functions[function], false, upvalue);
+    return -1;
+}
+int Resolver::addUpvalue(FunctionScope& function, bool isLocal, int index){
+    // each variable is captured once per function
+    for (size_t i = 0; i < function.upvalues.size(); i++){
+        const CapturedVariable& upvalue = function.upvalues[i];
+        if (upvalue.isLocal == isLocal && upvalue.index == index) return (int)i;
+    }
+    function.upvalues.push_back(CapturedVariable{isLocal, index});
+    return (int)function.upvalues.size() - 1;
 }
-void Resolver::resolveFunction(std::shared_ptr<FunctionStmt> func, FunctionType type){
+void Resolver::resolveFunction(FunctionStmt* func, FunctionType type){
     // switches resolving type to given type, resolves arguments and body, then restores previous type
+    // the function gets a frame of its own: 'this' (for methods), then its parameters
 
     const FunctionType enclosingType = currentFunction;
     currentFunction = type;
+    functions.emplace_back();
 
     beginScope();
-    for (Token token : func->params){
-        declare(token);
-        define(token);
+    if (type == FunctionType::METHOD || type == FunctionType::INITIALIZER){
+        Token self(Token::THIS, "this", Object::nil(), func->name.line);
+        func->isMethod = true;
+        declare(self, func->thisSlot);
+        define(self);
+    }
+    for (size_t i = 0; i < func->params.size(); i++){
+        declare(*func->params[i], func->paramSlots[i]);
+        define(*func->params[i]);
     }
     resolve(func->body);
     endScope();
 
+    func->frameSize = functions.back().frameSize;
+    func->upvalues = functions.back().upvalues;
+    functions.pop_back();
     currentFunction = enclosingType;
-}
\ No newline at end of file
+}
@@ -1,8 +1,7 @@
-// requires expressions, statements, access to ParseErrors and environments
+// requires expressions, statements and access to ParseErrors
 #include "expr.hpp"
 #include "stmt.hpp"
 #include "loxOutput.hpp"
-#include "environment.hpp"
 
 // implementation uses stacks
 #include <deque>
@@ -12,7 +11,7 @@
 // Interpreter not included: only declaration required
 class Interpreter;
 
-class Resolver : public ExprVisitor, public StmtVisitor{
+class Resolver : public ExprVisitor<void>, public StmtVisitor<void>{
     // Does semantic analysis on ASTs such that
     // scope is statically resolved and variables binded
     /*
@@ -20,48 +19,75 @@ class Resolver : public ExprVisitor, public StmtVisitor{
         1. There are no side effects. Input/output of print and native functions suppressed.
         2. There is no control flow.
         3. Errors are not thrown. Once error() is called, the returned ParseError has to be .print()
+        4. Each function's locals (blocks included) are assigned slots in one frame.
+           Slots of a block are reused once the block ends.
+        5. A local referenced from an inner function is captured: all of its nodes are
+           switched to VariableSlot::BOXED, and the inner functions record it as an upvalue.
     */
     public:
         bool hasError = false;
 
         Resolver(Interpreter& interpreter);
-        void resolve(std::shared_ptr<Expr> expr);
-        std::any visit(std::shared_ptr<Expr> curr) override;
-        void resolve(std::shared_ptr<Stmt> stmt);
-        void resolve(std::vector<std::shared_ptr<Stmt>> statements);
-        std::any visit(std::shared_ptr<Stmt> curr) override;
+        using ExprVisitor<void>::visit;
+        using StmtVisitor<void>::visit;
+        void resolve(Expr* expr);
+        void resolve(Stmt* stmt);
+        void resolve(std::vector<Stmt*>& statements);
 
         // EXPR CHILD CLASSES
-        std::any visitLiteralExpr(std::shared_ptr<LiteralExpr> curr) override;
-        std::any visitGroupingExpr(std::shared_ptr<GroupingExpr> curr) override;
-        std::any visitUnaryExpr(std::shared_ptr<UnaryExpr> curr) override;
-        std::any visitBinaryExpr(std::shared_ptr<BinaryExpr> curr) override;
+        void visitLiteralExpr(LiteralExpr* curr) override;
+        void visitGroupingExpr(GroupingExpr* curr) override;
+        void visitUnaryExpr(UnaryExpr* curr) override;
+        void visitBinaryExpr(BinaryExpr* curr) override;
         
-        std::any visitVariableExpr(std::shared_ptr<VariableExpr> curr) override;
-        std::any visitAssignExpr(std::shared_ptr<AssignExpr> curr) override;
-        std::any visitLogicalExpr(std::shared_ptr<LogicalExpr> curr) override;
+        void visitVariableExpr(VariableExpr* curr) override;
+        void visitAssignExpr(AssignExpr* curr) override;
+        void visitLogicalExpr(LogicalExpr* curr) override;
 
-        std::any visitCallExpr(std::shared_ptr<CallExpr> curr) override;
-        std::any visitGetExpr(std::shared_ptr<GetExpr> curr) override;
-        std::any visitSetExpr(std::shared_ptr<SetExpr> curr) override;
-        std::any visitThisExpr(std::shared_ptr<ThisExpr> curr) override;
-        std::any visitSuperExpr(std::shared_ptr<SuperExpr> curr) override;
+        void visitCallExpr(CallExpr* curr) override;
+        void visitGetExpr(GetExpr* curr) override;
+        void visitSetExpr(SetExpr* curr) override;
+        void visitThisExpr(ThisExpr* curr) override;
+        void visitSuperExpr(SuperExpr* curr) override;
 
         // STMT CHILD CLASSES
-        std::any visitExpressionStmt(std::shared_ptr<ExpressionStmt> curr) override;
-        std::any visitPrintStmt(std::shared_ptr<PrintStmt> curr) override;
-        std::any visitVarStmt(std::shared_ptr<VarStmt> curr) override;
-        std::any visitBlockStmt(std::shared_ptr<BlockStmt> curr) override;
+        void visitExpressionStmt(ExpressionStmt* curr) override;
+        void visitPrintStmt(PrintStmt* curr) override;
+        void visitVarStmt(VarStmt* curr) override;
+        void visitBlockStmt(BlockStmt* curr) override;
         
-        std::any visitIfStmt(std::shared_ptr<IfStmt> curr) override;
-        std::any visitWhileStmt(std::shared_ptr<WhileStmt> curr) override;
+        void visitIfStmt(IfStmt* curr) override;
+        void visitWhileStmt(WhileStmt* curr) override;
 
-        std::any visitFunctionStmt(std::shared_ptr<FunctionStmt> curr) override;
-        std::any visitReturnStmt(std::shared_ptr<ReturnStmt> curr) override;
-        std::any visitClassStmt(std::shared_ptr<ClassStmt> curr) override;
+        void visitFunctionStmt(FunctionStmt* curr) override;
+        void visitReturnStmt(ReturnStmt* curr) override;
+        void visitClassStmt(ClassStmt* curr) override;
+
+        // slots needed by the frame of top-level code (for variables of top-level blocks)
+        int frameSize(void);
 
     private:
-        std::deque<std::unordered_map<std::string, bool>> scopes;
+        struct Local{
+            // whether the variable's initializer has been resolved,
+            // its index in the frame, whether a closure captures it,
+            // and every node of the function that refers to it (to be BOXED once captured)
+            bool defined;
+            int slot;
+            bool captured;
+            std::vector<VariableSlot*> nodes;
+        };
+        struct Scope{
+            std::unordered_map<std::string, Local> locals;
+            int firstSlot;    // slots from here onwards are released at the end of the scope
+        };
+        struct FunctionScope{
+            // the scopes of one function being resolved (or of top-level code)
+            std::deque<Scope> scopes;
+            std::vector<CapturedVariable> upvalues;
+            int nextSlot = 0;
+            int frameSize = 0;
+        };
+        std::deque<FunctionScope> functions;
         Interpreter& interpreter;
         enum class FunctionType{
             NONE, FUNCTION, 
@@ -73,11 +99,14 @@ class Resolver : public ExprVisitor, public StmtVisitor{
         FunctionType currentFunction;
         ClassType currentClass;
 
-        LoxError::ParseError error(Token token, std::string message);
+        LoxError::ParseError error(const Token& token, std::string message);
+        std::deque<Scope>& scopes(void);
         void beginScope(void);
         void endScope(void);
-        void declare(Token name);
-        void define(Token name);
-        void resolveLocal(std::shared_ptr<Expr> expr, Token name);
-        void resolveFunction(std::shared_ptr<FunctionStmt> func, FunctionType type);
+        void declare(const Token& name, VariableSlot& slot);
+        void define(const Token& name);
+        void resolveLocal(VariableSlot& slot, const Token& name);
+        int resolveUpvalue(int function, const Token& name);
+        int addUpvalue(FunctionScope& function, bool isLocal, int index);
+        void resolveFunction(FunctionStmt* func, FunctionType type);
 };
\ No newline at end of file
@@ -0,0 +1,17 @@
+#include "shape.hpp"
+
+Shape* Shape::empty(void){
+    static Shape shape;
+    return &shape;
+}
+
+Shape* Shape::add(const std::string& name){
+    // transitions are shared, so instances adding the same fields in the same order share shapes
+    std::unique_ptr<Shape>& child = transitions[name];
+    if (!child){
+        child = std::make_unique<Shape>();
+        child->slots = slots;
+        child->slots[name] = (int)slots.size();
+    }
+    return child.get();
+}
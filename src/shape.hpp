@@ -0,0 +1,53 @@
+// required for the slots and transitions of a shape
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#pragma once
+
+class Shape{
+    // The layout of the fields of an instance (a hidden class): the slot of LoxInstance::fields
+    // holding each field. Instances start with the empty shape, and move to a child shape
+    // each time a field is added.
+    /*
+        KEY NOTES:
+        1. Shapes are shared: instances that added the same fields in the same order have
+           the same shape, so a property access site sees few of them (see PropertyCache).
+        2. Shapes are immutable, and live as long as the program: each owns its transitions.
+    */
+    public:
+        static Shape* empty(void);
+        // slot of the field [name], or -1 if this shape has no such field
+        int find(const std::string& name) const {
+            auto it = slots.find(name);
+            return it == slots.end() ? -1 : it->second;
+        }
+        // the shape with field [name] added (in the last slot)
+        Shape* add(const std::string& name);
+        size_t size(void) const { return slots.size(); }
+
+    private:
+        std::unordered_map<std::string, int> slots = {};
+        std::unordered_map<std::string, std::unique_ptr<Shape>> transitions = {};
+};
+
+struct PropertyCache{
+    // Inline cache of a property access site (GetExpr, SetExpr): the shapes of the instances
+    // seen there, and the slot of the field for each. Monomorphic with one entry,
+    // polymorphic up to [size]; shapes seen once it is full are looked up every time.
+    // For a SetExpr adding the field, [next] is the shape after adding it (else the shape itself).
+    static constexpr int size = 4;
+    const Shape* shapes[size] = {};
+    Shape* next[size] = {};
+    std::uint32_t slots[size] = {};
+    std::uint8_t count = 0;
+
+    void add(const Shape* shape, Shape* nextShape, std::uint32_t slot){
+        if (count == size) return;
+        shapes[count] = shape;
+        next[count] = nextShape;
+        slots[count] = slot;
+        count++;
+    }
+};
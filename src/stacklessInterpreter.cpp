@@ -0,0 +1,328 @@
+#include "stacklessInterpreter.hpp"
+
+void StacklessInterpreter::interpret(std::vector<Stmt*>& statements, int frameSize){
+    start(statements, frameSize);
+    resume();
+}
+
+void StacklessInterpreter::start(std::vector<Stmt*>& statements, int frameSize){
+    // the program runs in a frame of [frameSize] slots (locals of top-level blocks),
+    // which is not counted in [frames]
+    reset();
+    interpreter.stack.resize(frameSize);
+    tasks.push_back(Task(Task::STATEMENTS, &statements));
+}
+bool StacklessInterpreter::resume(size_t steps){
+    // on a RuntimeError, every frame is popped and the program abandoned
+    try{
+        while (steps > 0 && !tasks.empty()){
+            step();
+            steps--;
+        }
+    }
+    catch (...){
+        reset();
+        throw;
+    }
+    if (!tasks.empty()) return false;
+    reset();
+    return true;
+}
+void StacklessInterpreter::reset(void){
+    tasks.clear();
+    values.clear();
+    frames.clear();
+    interpreter.stack.clear();
+    interpreter.frameBase = 0;
+    interpreter.closure = nullptr;
+}
+
+Object StacklessInterpreter::pop(void){
+    Object obj = std::move(values.back());
+    values.pop_back();
+    return obj;
+}
+
+
+// ---STEPS---
+// each step advances the task on top of the stack: it pushes a task for an operand
+// (whose value the next step of this task finds on the value stack), or completes.
+// a task is popped once complete, leaving its value (if an expression) on the value stack.
+// tasks that end with a single operand replace themselves by it instead (eg. if, grouping)
+void StacklessInterpreter::step(void){
+    Task& task = tasks.back();
+    switch (task.kind){
+        case Task::EXPR: return stepExpr(task.expr);
+        case Task::STMT: return stepStmt(task.stmt);
+        default:{
+            if (task.step < task.statements->size()){
+                Stmt* stmt = (*task.statements)[task.step++];
+                tasks.push_back(Task(stmt));
+            }
+            else if (task.kind == Task::BODY) returnFrom(Object::nil());
+            else tasks.pop_back();
+            return;
+        }
+    }
+}
+
+void StacklessInterpreter::stepExpr(Expr* expr){
+    const uint32_t step = tasks.back().step++;
+    switch (expr->type){
+        case Expr::LITERAL:
+            values.push_back(static_cast<LiteralExpr*>(expr)->obj);
+            tasks.pop_back();
+            return;
+        case Expr::GROUPING:
+            tasks.back() = Task(static_cast<GroupingExpr*>(expr)->expr);
+            return;
+        case Expr::UNARY:{
+            UnaryExpr* curr = static_cast<UnaryExpr*>(expr);
+            if (step == 0) return tasks.push_back(Task(curr->expr));
+            values.back() = interpreter.unary(curr, values.back());
+            tasks.pop_back();
+            return;
+        }
+        case Expr::BINARY:{
+            BinaryExpr* curr = static_cast<BinaryExpr*>(expr);
+            if (step == 0) return tasks.push_back(Task(curr->left));
+            if (step == 1) return tasks.push_back(Task(curr->right));
+            Object right = pop();
+            values.back() = interpreter.binary(curr, values.back(), right);
+            tasks.pop_back();
+            return;
+        }
+
+        case Expr::VARIABLE:
+            values.push_back(interpreter.visitVariableExpr(static_cast<VariableExpr*>(expr)));
+            tasks.pop_back();
+            return;
+        case Expr::ASSIGN:{
+            AssignExpr* curr = static_cast<AssignExpr*>(expr);
+            if (step == 0) return tasks.push_back(Task(curr->expr));
+            interpreter.assign(curr, values.back());
+            tasks.pop_back();
+            return;
+        }
+        case Expr::LOGICAL:{
+            // short circuit: leave the left operand as the value. otherwise replace it by the right
+            LogicalExpr* curr = static_cast<LogicalExpr*>(expr);
+            if (step == 0) return tasks.push_back(Task(curr->left));
+            const bool truthy = interpreter.isTruthy(values.back());
+            if (curr->op.type == Token::OR ? truthy : !truthy){
+                tasks.pop_back();
+                return;
+            }
+            values.pop_back();
+            tasks.back() = Task(curr->right);
+            return;
+        }
+
+        case Expr::CALL:{
+            // evaluate the callee, then each argument, then call
+            CallExpr* curr = static_cast<CallExpr*>(expr);
+            if (curr->callee->type == Expr::GET){
+                // a method call: the method is invoked unbound. the callee is the method
+                // followed by the object, its receiver (or by nil, if the property is not a method)
+                GetExpr* get = static_cast<GetExpr*>(curr->callee);
+                if (step == 0) return tasks.push_back(Task(get->expr));
+                if (step == 1){
+                    LoxFunction* method = interpreter.invokedMethod(get, values.back());
+                    if (method){
+                        Object obj = pop();
+                        values.push_back(Object::function(method));
+                        values.push_back(std::move(obj));
+                    }
+                    else{
+                        values.back() = interpreter.getProperty(get, values.back());
+                        values.push_back(Object::nil());
+                    }
+                }
+                if (step <= curr->arguments.size()) return tasks.push_back(Task(curr->arguments[step - 1]));
+                return call(curr, tasks.back().tail);
+            }
+            if (step == 0) return tasks.push_back(Task(curr->callee));
+            if (step <= curr->arguments.size()) return tasks.push_back(Task(curr->arguments[step - 1]));
+            return call(curr, tasks.back().tail);
+        }
+        case Expr::GET:{
+            GetExpr* curr = static_cast<GetExpr*>(expr);
+            if (step == 0) return tasks.push_back(Task(curr->expr));
+            values.back() = interpreter.getProperty(curr, values.back());
+            tasks.pop_back();
+            return;
+        }
+        case Expr::SET:{
+            SetExpr* curr = static_cast<SetExpr*>(expr);
+            if (step == 0) return tasks.push_back(Task(curr->expr));
+            if (step == 1){
+                interpreter.checkInstance(curr, values.back());
+                return tasks.push_back(Task(curr->value));
+            }
+            Object value = pop();
+            interpreter.setProperty(curr, values.back(), value);
+            values.back() = value;
+            tasks.pop_back();
+            return;
+        }
+        default:
+            // 'this' and 'super' are variable lookups
+            values.push_back(interpreter.visit(expr));
+            tasks.pop_back();
+            return;
+    }
+}
+
+void StacklessInterpreter::stepStmt(Stmt* stmt){
+    const uint32_t step = tasks.back().step++;
+    switch (stmt->type){
+        case Stmt::EXPRESSION:
+            if (step == 0) return tasks.push_back(Task(static_cast<ExpressionStmt*>(stmt)->expr));
+            values.pop_back();
+            tasks.pop_back();
+            return;
+        case Stmt::PRINT:
+            if (step == 0) return tasks.push_back(Task(static_cast<PrintStmt*>(stmt)->expr));
+            interpreter.print(pop());
+            tasks.pop_back();
+            return;
+        case Stmt::VAR:{
+            VarStmt* curr = static_cast<VarStmt*>(stmt);
+            if (step == 0 && curr->initializer) return tasks.push_back(Task(curr->initializer));
+            interpreter.defineVariable(curr->slot, curr->initializer ? pop() : Object::nil());
+            tasks.pop_back();
+            return;
+        }
+        case Stmt::BLOCK:
+            tasks.back() = Task(Task::STATEMENTS, &static_cast<BlockStmt*>(stmt)->statements);
+            return;
+
+        case Stmt::IF:{
+            IfStmt* curr = static_cast<IfStmt*>(stmt);
+            if (step == 0) return tasks.push_back(Task(curr->condition));
+            if (interpreter.isTruthy(pop())) tasks.back() = Task(curr->thenBranch);
+            else if (curr->elseBranch) tasks.back() = Task(curr->elseBranch);
+            else tasks.pop_back();
+            return;
+        }
+        case Stmt::WHILE:{
+            // after the body, start over from the condition
+            WhileStmt* curr = static_cast<WhileStmt*>(stmt);
+            if (step == 0) return tasks.push_back(Task(curr->condition));
+            if (interpreter.isTruthy(pop())){
+                tasks.back().step = 0;
+                tasks.push_back(Task(curr->body));
+            }
+            else tasks.pop_back();
+            return;
+        }
+
+        case Stmt::RETURN:{
+            ReturnStmt* curr = static_cast<ReturnStmt*>(stmt);
+            if (step == 0){
+                if (curr->tailCall) return tasks.push_back(Task(curr->tailCall, true));
+                if (curr->expr) return tasks.push_back(Task(curr->expr));
+                return returnFrom(Object::nil());
+            }
+            return returnFrom(pop());
+        }
+        default:
+            // declarations of functions and classes evaluate no expression that may call
+            interpreter.visit(stmt);
+            tasks.pop_back();
+            return;
+    }
+}
+
+
+// ---CALLS---
+void StacklessInterpreter::call(CallExpr* curr, bool tail){
+    // the callee and arguments are on top of the value stack
+    size_t arguments = values.size() - curr->arguments.size();
+    size_t callee = arguments - 1;
+    Ref<LoxFunction> function = nullptr;
+    Ref<LoxInstance> receiver = nullptr;
+
+    if (curr->callee->type == Expr::GET && values[arguments - 1].type != Object::NIL){
+        // a method invoked unbound, below its receiver (see stepExpr)
+        callee = arguments - 2;
+        interpreter.checkCall(curr, values[callee], curr->arguments.size());
+        function = values[callee].as<LoxFunction>();
+        receiver = values[arguments - 1].as<LoxInstance>();
+    }
+    else{
+        // a property that is not a method is called as its value, without a receiver
+        if (curr->callee->type == Expr::GET) values.erase(values.begin() + (arguments-- - 1));
+        callee = arguments - 1;
+        interpreter.checkCall(curr, values[callee], curr->arguments.size());
+        function = curr->cache.function;
+        if (function) receiver = function->receiver;
+    }
+
+    if (!function && values[callee].type == Object::LOX_CLASS){
+        // instantiate here rather than in LoxClass::call, so that the initializer gets a frame
+        LoxClass* loxClass = values[callee].as<LoxClass>();
+        receiver = makeRef<LoxInstance>(loxClass);
+        function = loxClass->initializer;
+        if (!function){
+            values.resize(callee);
+            values.push_back(Object::instance(receiver));
+            tasks.pop_back();
+            return;
+        }
+    }
+    else if (!function){
+        // native functions do not call back into Lox
+        Object result = values[callee].as<LoxCallable>()->call(interpreter,
+            std::span<Object>(values.data() + arguments, values.size() - arguments));
+        values.resize(callee);
+        values.push_back(result);
+        tasks.pop_back();
+        return;
+    }
+
+    if (tail){
+        // replace the frame of the caller, dropping everything it was executing
+        Frame& frame = frames.back();
+        tasks.erase(tasks.begin() + frame.tasks, tasks.end());
+        interpreter.stack.resize(frame.base);
+        frame.function = function;
+        frame.receiver = receiver;
+        return enter(frame, arguments);
+    }
+
+    if (frames.size() >= maxDepth) throw interpreter.error(curr->paren, "Stack overflow.");
+    // the call completes once the callee returns, leaving its value in place of the callee
+    tasks.pop_back();
+    frames.push_back(Frame{function, receiver, interpreter.stack.size(), interpreter.frameBase, interpreter.closure,
+        tasks.size(), callee});
+    enter(frames.back(), arguments);
+}
+void StacklessInterpreter::enter(Frame& frame, size_t arguments){
+    // sets up the frame of a call, as LoxFunction::call does: 'this' (for methods)
+    // and the arguments (from the value stack, at [arguments]) in their slots
+    FunctionStmt* declaration = frame.function->declaration;
+    interpreter.stack.resize(frame.base + declaration->frameSize);
+    interpreter.frameBase = frame.base;
+    interpreter.closure = frame.function.get();
+
+    if (declaration->isMethod)
+        interpreter.defineVariable(declaration->thisSlot, Object::instance(frame.receiver));
+    for (size_t i = 0; i < declaration->params.size(); i++)
+        interpreter.defineVariable(declaration->paramSlots[i], values[arguments + i]);
+    values.resize(frame.values);
+    tasks.push_back(Task(Task::BODY, &declaration->body));
+}
+void StacklessInterpreter::returnFrom(Object value){
+    // pops the frame of the current call, and everything it was executing
+    // initializers return 'this'
+    Frame& frame = frames.back();
+    Object result = frame.function->isInitializer ? Object::instance(frame.receiver) : value;
+    tasks.erase(tasks.begin() + frame.tasks, tasks.end());
+    values.resize(frame.values);
+    interpreter.stack.resize(frame.base);
+    interpreter.frameBase = frame.prevBase;
+    interpreter.closure = frame.prevClosure;
+    frames.pop_back();
+    values.push_back(std::move(result));
+}
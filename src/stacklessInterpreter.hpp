@@ -0,0 +1,80 @@
+// requires the Interpreter, whose state (globals, frames) and operations are shared
+#include "interpreter.hpp"
+
+// required for the step budget of resume()
+#include <cstdint>
+#include <limits>
+
+#pragma once
+
+class StacklessInterpreter{
+    // Interprets an AST without recursing on the native stack.
+    // Every expression and statement being executed is a Task on an explicit stack,
+    // which advances one [step] at a time; operands and results go on a value stack;
+    // every Lox call pushes a Frame. All three live on the heap, so the depth of Lox
+    // recursion is bounded by [maxDepth] rather than by the native stack.
+    /*
+        KEY NOTES:
+        1. Shares its state with an Interpreter: globals, the stack of local slots, and the
+           work of each node on evaluated operands (Interpreter::binary, ::assign, ...).
+        2. A call deeper than [maxDepth] frames throws a RuntimeError ("Stack overflow.").
+        3. Execution may be suspended after any number of steps and resumed later: the state
+           is entirely in [tasks], [values] and [frames]. The program must outlive it.
+        4. Tail calls (see ReturnStmt::tailCall) replace the frame of the caller,
+           so tail recursion does not count towards [maxDepth].
+    */
+    public:
+        static constexpr size_t defaultMaxDepth = 100000;
+        size_t maxDepth = defaultMaxDepth;
+
+        StacklessInterpreter(Interpreter& interpreter) : interpreter(interpreter) {}
+        void interpret(std::vector<Stmt*>& statements, int frameSize);
+
+        // runs a program for at most [steps] steps. returns true once it has finished
+        void start(std::vector<Stmt*>& statements, int frameSize);
+        bool resume(size_t steps = std::numeric_limits<size_t>::max());
+        bool finished(void) const { return tasks.empty(); }
+
+    private:
+        struct Task{
+            // a node being executed, and how far along it is
+            // STATEMENTS is a list of statements; BODY is the body of a function,
+            // which returns nil when it runs to its end
+            enum Kind : std::uint8_t { EXPR, STMT, STATEMENTS, BODY };
+            Kind kind;
+            bool tail = false;      // a CallExpr in tail position
+            uint32_t step = 0;
+            union{
+                Expr* expr;
+                Stmt* stmt;
+                std::vector<Stmt*>* statements;
+            };
+            Task(Expr* expr, bool tail = false) : kind(EXPR), tail(tail), expr(expr) {}
+            Task(Stmt* stmt) : kind(STMT), stmt(stmt) {}
+            Task(Kind kind, std::vector<Stmt*>* statements) : kind(kind), statements(statements) {}
+        };
+        struct Frame{
+            // a call of a user-defined function
+            Ref<LoxFunction> function;
+            Ref<LoxInstance> receiver;  // 'this' of a method
+            size_t base;                // slot 0 of the call in Interpreter::stack
+            size_t prevBase;            // frame of the caller
+            LoxFunction* prevClosure;
+            size_t tasks;               // depth of the task stack at the call
+            size_t values;              // depth of the value stack at the call (callee excluded)
+        };
+        Interpreter& interpreter;
+        std::vector<Task> tasks = {};
+        std::vector<Object> values = {};
+        std::vector<Frame> frames = {};
+
+        void step(void);
+        void stepExpr(Expr* expr);
+        void stepStmt(Stmt* stmt);
+        void call(CallExpr* curr, bool tail);
+        void enter(Frame& frame, size_t arguments);
+        void returnFrom(Object value);
+        void reset(void);
+
+        Object pop(void);
+};
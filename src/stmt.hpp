@@ -16,23 +16,31 @@ class FunctionStmt;
 class ReturnStmt;
 class ClassStmt;
 
+// compiled bodies of a function (see ClosureCompiler, FlatCompiler and BytecodeCompiler)
+class StmtCode;
+class Chunk;
+// machine code of a hot numeric function (see Jit)
+class JitCode;
+
+template<typename R>
 class StmtVisitor{
     // Abstract class implementing the Visitor design pattern for Stmt.
+    // Each visit returns R directly (Completion for the Interpreter, void for the Resolver).
     public:
         virtual ~StmtVisitor(void) = default;
-        virtual std::any visit(std::shared_ptr<Stmt> curr) = 0;
+        R visit(Stmt* curr);
         
-        virtual std::any visitExpressionStmt(std::shared_ptr<ExpressionStmt> curr) = 0;
-        virtual std::any visitPrintStmt(std::shared_ptr<PrintStmt> curr) = 0;
-        virtual std::any visitVarStmt(std::shared_ptr<VarStmt> curr) = 0;
-        virtual std::any visitBlockStmt(std::shared_ptr<BlockStmt> curr) = 0;
+        virtual R visitExpressionStmt(ExpressionStmt* curr) = 0;
+        virtual R visitPrintStmt(PrintStmt* curr) = 0;
+        virtual R visitVarStmt(VarStmt* curr) = 0;
+        virtual R visitBlockStmt(BlockStmt* curr) = 0;
 
-        virtual std::any visitIfStmt(std::shared_ptr<IfStmt> curr) = 0;
-        virtual std::any visitWhileStmt(std::shared_ptr<WhileStmt> curr) = 0;
+        virtual R visitIfStmt(IfStmt* curr) = 0;
+        virtual R visitWhileStmt(WhileStmt* curr) = 0;
 
-        virtual std::any visitFunctionStmt(std::shared_ptr<FunctionStmt> curr) = 0;
-        virtual std::any visitReturnStmt(std::shared_ptr<ReturnStmt> curr) = 0;
-        virtual std::any visitClassStmt(std::shared_ptr<ClassStmt> curr) = 0;
+        virtual R visitFunctionStmt(FunctionStmt* curr) = 0;
+        virtual R visitReturnStmt(ReturnStmt* curr) = 0;
+        virtual R visitClassStmt(ClassStmt* curr) = 0;
 };
 
 /*
@@ -43,97 +51,136 @@ exprDecl       → expression ";" ;
 
 class Stmt{
     // Abstract class implementing statements.
-    // Supports the Visitor design pattern via StmtVisitor, which is passed by reference.
+    // Supports the Visitor design pattern via StmtVisitor, which dispatches on [type].
     public:
+        enum StmtType : std::uint8_t {
+            EXPRESSION, PRINT, VAR, BLOCK,
+            IF, WHILE,
+            FUNCTION, RETURN, CLASS
+        };
+        const StmtType type;
+        Stmt(StmtType type) : type(type) {}
         virtual ~Stmt(void) = default;
-        virtual std::any accept(StmtVisitor& v) = 0;
 };
 
 
 // ---CHILD CLASSES---
-// note: enable_shared_from_this MUST BE inherited as PUBLIC
 
-class ExpressionStmt : public Stmt, public std::enable_shared_from_this<ExpressionStmt>{
+class ExpressionStmt : public Stmt{
     // A statment wrapping an expression
     // Not to be confused with the abstract class Expr
     public:
-        std::shared_ptr<Expr> expr;
-        ExpressionStmt(std::shared_ptr<Expr> expr) : expr(expr) {}
-        std::any accept(StmtVisitor& v) override { return v.visitExpressionStmt(shared_from_this()); }
+        Expr* expr;
+        ExpressionStmt(Expr* expr) : Stmt(EXPRESSION), expr(expr) {}
 };
-class PrintStmt : public Stmt, public std::enable_shared_from_this<PrintStmt>{
+class PrintStmt : public Stmt{
     // A print statment
     public:
-        std::shared_ptr<Expr> expr;
-        PrintStmt(std::shared_ptr<Expr> expr) : expr(expr) {}
-        std::any accept(StmtVisitor& v) override { return v.visitPrintStmt(shared_from_this()); }
+        Expr* expr;
+        PrintStmt(Expr* expr) : Stmt(PRINT), expr(expr) {}
 };
-class VarStmt : public Stmt, public std::enable_shared_from_this<VarStmt>{
+class VarStmt : public Stmt{
     // A statement of a variable DECLARATION
     // Not to be confused with Variable : Expr
     public:
-        Token name;
-        std::shared_ptr<Expr> initializer;
-        VarStmt(Token name, std::shared_ptr<Expr> initializer) : name(name), initializer(initializer) {}
-        std::any accept(StmtVisitor& v) override { return v.visitVarStmt(shared_from_this()); }
+        const Token& name;
+        Expr* initializer;
+        VariableSlot slot;
+        VarStmt(const Token& name, Expr* initializer) : Stmt(VAR), name(name), initializer(initializer) {}
 };
-class BlockStmt : public Stmt, public std::enable_shared_from_this<BlockStmt>{
+class BlockStmt : public Stmt{
     // A statement of a block in lexical scope
     public:
-        std::vector<std::shared_ptr<Stmt>> statements;
-        BlockStmt(std::vector<std::shared_ptr<Stmt>> statements) : statements(statements) {}
-        std::any accept(StmtVisitor& v) override { return v.visitBlockStmt(shared_from_this()); }
+        std::vector<Stmt*> statements;
+        BlockStmt(std::vector<Stmt*> statements) : Stmt(BLOCK), statements(statements) {}
 };
 
 
 // ---CHILD CLASSES (CONTROL FLOW)---
-class IfStmt : public Stmt, public std::enable_shared_from_this<IfStmt>{
+class IfStmt : public Stmt{
     // A statement encapsulating an if-then-else control flow
     public:
-        std::shared_ptr<Expr> condition;
-        std::shared_ptr<Stmt> thenBranch;
-        std::shared_ptr<Stmt> elseBranch;
-        IfStmt(std::shared_ptr<Expr> condition, std::shared_ptr<Stmt> thenBranch, std::shared_ptr<Stmt> elseBranch) :
-            condition(condition), thenBranch(thenBranch), elseBranch(elseBranch) {}
-        std::any accept(StmtVisitor& v) override { return v.visitIfStmt(shared_from_this()); }
+        Expr* condition;
+        Stmt* thenBranch;
+        Stmt* elseBranch;
+        IfStmt(Expr* condition, Stmt* thenBranch, Stmt* elseBranch) :
+            Stmt(IF), condition(condition), thenBranch(thenBranch), elseBranch(elseBranch) {}
 };
-class WhileStmt : public Stmt, public std::enable_shared_from_this<WhileStmt>{
+class WhileStmt : public Stmt{
     // A statement encapsulating a while loop
     public:
-        std::shared_ptr<Expr> condition;
-        std::shared_ptr<Stmt> body;
-        WhileStmt(std::shared_ptr<Expr> condition, std::shared_ptr<Stmt> body) :
-            condition(condition), body(body) {}
-        std::any accept(StmtVisitor& v) override { return v.visitWhileStmt(shared_from_this()); }
+        Expr* condition;
+        Stmt* body;
+        WhileStmt(Expr* condition, Stmt* body) :
+            Stmt(WHILE), condition(condition), body(body) {}
 };
 
 
 // ---CHILD CLASSES (FUNCTIONS AND CLASSES)---
-class FunctionStmt : public Stmt, public std::enable_shared_from_this<FunctionStmt>{
+struct CapturedVariable{
+    // a variable captured by a closure when it is created:
+    // a BOXED slot of the enclosing frame (isLocal), or an upvalue of the enclosing closure
+    bool isLocal;
+    int index;
+};
+class FunctionStmt : public Stmt{
     // A statement encapsulating a function declaration
     public:
-        Token name;
-        std::vector<Token> params;
-        std::vector<std::shared_ptr<Stmt>> body;
-        FunctionStmt(Token name, std::vector<Token> params, std::vector<std::shared_ptr<Stmt>> body) :
-            name(name), params(params), body(body) {}
-        std::any accept(StmtVisitor& v) override { return v.visitFunctionStmt(shared_from_this()); }
+        const Token& name;
+        std::vector<const Token*> params;
+        std::vector<Stmt*> body;
+
+        // written by the Resolver
+        VariableSlot slot;                         // the function's name
+        std::vector<VariableSlot> paramSlots;      // its parameters
+        bool isMethod = false;                     // methods receive 'this' in frame slot 0
+        VariableSlot thisSlot;
+        int frameSize = 0;                         // slots needed by one call
+        std::vector<CapturedVariable> upvalues;
+
+        // written by the ClosureCompiler (or the FlatCompiler). calls run it instead of walking [body]
+        StmtCode* code = nullptr;
+        // written by the BytecodeCompiler, for the VM
+        Chunk* chunk = nullptr;
+        // written by LoxFunction::call: calls so far, and the code compiled once they reach Jit::threshold
+        unsigned calls = 0;
+        JitCode* jit = nullptr;
+        FunctionStmt(const Token& name, std::vector<const Token*> params, std::vector<Stmt*> body) :
+            Stmt(FUNCTION), name(name), params(params), body(body), paramSlots(params.size()) {}
 };
-class ReturnStmt : public Stmt, public std::enable_shared_from_this<ReturnStmt>{
+class ReturnStmt : public Stmt{
     // A return statment (from a function or method)
     public:
-        Token keyword;
-        std::shared_ptr<Expr> expr;
-        ReturnStmt(Token keyword, std::shared_ptr<Expr> expr) : keyword(keyword), expr(expr) {}
-        std::any accept(StmtVisitor& v) override { return v.visitReturnStmt(shared_from_this()); }
+        const Token& keyword;
+        Expr* expr;
+        CallExpr* tailCall = nullptr;       // set by the Resolver if [expr] is a call (in tail position)
+        ReturnStmt(const Token& keyword, Expr* expr) : Stmt(RETURN), keyword(keyword), expr(expr) {}
 };
-class ClassStmt : public Stmt, public std::enable_shared_from_this<ClassStmt>{
+class ClassStmt : public Stmt{
     // A statement encapsulating a class declaration
     public:
-        Token name;
-        std::shared_ptr<VariableExpr> superclass;
-        std::vector<std::shared_ptr<FunctionStmt>> methods;
-        ClassStmt(Token name, std::shared_ptr<VariableExpr> superclass, std::vector<std::shared_ptr<FunctionStmt>> methods) : 
-            name(name), superclass(superclass), methods(methods) {}
-        std::any accept(StmtVisitor& v) override { return v.visitClassStmt(shared_from_this()); }
-};
\ No newline at end of file
+        const Token& name;
+        VariableExpr* superclass;
+        std::vector<FunctionStmt*> methods;
+        VariableSlot slot;         // the class's name
+        VariableSlot superSlot;    // 'super', in a scope enclosing the methods
+        ClassStmt(const Token& name, VariableExpr* superclass, std::vector<FunctionStmt*> methods) :
+            Stmt(CLASS), name(name), superclass(superclass), methods(methods) {}
+};
+
+
+template<typename R>
+R StmtVisitor<R>::visit(Stmt* curr){
+    // dispatches on the type of [curr], without a virtual accept() or a type-erased result
+    switch (curr->type){
+        case Stmt::EXPRESSION: return visitExpressionStmt(static_cast<ExpressionStmt*>(curr));
+        case Stmt::PRINT: return visitPrintStmt(static_cast<PrintStmt*>(curr));
+        case Stmt::VAR: return visitVarStmt(static_cast<VarStmt*>(curr));
+        case Stmt::BLOCK: return visitBlockStmt(static_cast<BlockStmt*>(curr));
+        case Stmt::IF: return visitIfStmt(static_cast<IfStmt*>(curr));
+        case Stmt::WHILE: return visitWhileStmt(static_cast<WhileStmt*>(curr));
+        case Stmt::FUNCTION: return visitFunctionStmt(static_cast<FunctionStmt*>(curr));
+        case Stmt::RETURN: return visitReturnStmt(static_cast<ReturnStmt*>(curr));
+        default: return visitClassStmt(static_cast<ClassStmt*>(curr));
+    }
+}
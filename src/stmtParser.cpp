@@ -29,17 +29,17 @@ printStmt      → "print" expression ";" ;
 exprDecl       → expression ";" ;
 */
 
-std::vector<std::shared_ptr<Stmt>> StmtParser::parse(bool parseExpr){
+std::vector<Stmt*> StmtParser::parse(bool parseExpr){
     hasError = false;
     curr = 0;
-    std::vector<std::shared_ptr<Stmt>> statements = {};
+    std::vector<Stmt*> statements = {};
 
     // expression mode: attempt to parse tokens as expression
     // if successful, encapsulate as print statement
     if (parseExpr){
-        std::shared_ptr<Expr> expr = ExprParser::parse(true);
+        Expr* expr = ExprParser::parse(true);
         if (!hasError){
-            statements.push_back(std::make_shared<PrintStmt>(expr));
+            statements.push_back(arena.make<PrintStmt>(expr));
             return statements;
         }
     }
@@ -51,7 +51,7 @@ std::vector<std::shared_ptr<Stmt>> StmtParser::parse(bool parseExpr){
 
     // while not at end, parse statements
     while (!isAtEnd()){
-        std::shared_ptr<Stmt> stmt = declaration();
+        Stmt* stmt = declaration();
         // only push non-empty pointers
         if (stmt) statements.push_back(stmt);
     }
@@ -59,7 +59,7 @@ std::vector<std::shared_ptr<Stmt>> StmtParser::parse(bool parseExpr){
 }
 
 // ---BASE STATEMENTS---
-std::shared_ptr<Stmt> StmtParser::declaration(){
+Stmt* StmtParser::declaration(){
     try {
         if (match(Token::CLASS)) return classDeclaration();
         if (match(Token::FUN)) return functionDeclaration("function");
@@ -73,38 +73,38 @@ std::shared_ptr<Stmt> StmtParser::declaration(){
         return nullptr;
     }
 }
-std::shared_ptr<Stmt> StmtParser::varDeclaration(){
-    Token name = consume(Token::IDENTIFIER, "Expect variable name.");
-    std::shared_ptr<Expr> initializer = nullptr;
+Stmt* StmtParser::varDeclaration(){
+    const Token& name = consume(Token::IDENTIFIER, "Expect variable name.");
+    Expr* initializer = nullptr;
     if (match(Token::EQUAL)){
         initializer = expression();
     }
     consume(Token::SEMICOLON, "Expect ';' after variable declaration.");
-    return std::make_shared<VarStmt>(name, initializer);
+    return arena.make<VarStmt>(name, initializer);
 }
-std::shared_ptr<Stmt> StmtParser::statement(){
+Stmt* StmtParser::statement(){
     if (match(Token::PRINT)) return printStatement();
-    if (match(Token::LEFT_BRACE)) return std::make_shared<BlockStmt>(block());
+    if (match(Token::LEFT_BRACE)) return arena.make<BlockStmt>(block());
     if (match(Token::IF)) return ifStatement();
     if (match(Token::WHILE)) return whileStatement();
     if (match(Token::FOR)) return forStatement();
     if (match(Token::RETURN)) return returnStatement();
     return exprStatement();
 }
-std::shared_ptr<Stmt> StmtParser::exprStatement(){
-    std::shared_ptr<Expr> expr = expression();
+Stmt* StmtParser::exprStatement(){
+    Expr* expr = expression();
     consume(Token::SEMICOLON, "Expect ';' after expression.");
-    return std::make_shared<ExpressionStmt>(expr);
+    return arena.make<ExpressionStmt>(expr);
 }
-std::shared_ptr<Stmt> StmtParser::printStatement(){
-    std::shared_ptr<Expr> expr = expression();
+Stmt* StmtParser::printStatement(){
+    Expr* expr = expression();
     consume(Token::SEMICOLON, "Expect ';' after value.");
-    return std::make_shared<PrintStmt>(expr);
+    return arena.make<PrintStmt>(expr);
 }
-std::vector<std::shared_ptr<Stmt>> StmtParser::block(){
-    std::vector<std::shared_ptr<Stmt>> statements = {};
+std::vector<Stmt*> StmtParser::block(){
+    std::vector<Stmt*> statements = {};
     while (!check(Token::RIGHT_BRACE) && !isAtEnd()){
-        std::shared_ptr<Stmt> stmt = declaration();
+        Stmt* stmt = declaration();
         // only push non-empty pointers
         if (stmt) statements.push_back(stmt);
     }
@@ -113,27 +113,27 @@ std::vector<std::shared_ptr<Stmt>> StmtParser::block(){
 }
 
 // ---CONTROL FLOW---
-std::shared_ptr<Stmt> StmtParser::ifStatement(){
+Stmt* StmtParser::ifStatement(){
     consume(Token::LEFT_PAREN, "Expect '(' after 'if'.");
-    std::shared_ptr<Expr> condition = expression();
+    Expr* condition = expression();
     consume(Token::RIGHT_PAREN, "Expect ')' after if condition.");
 
     // parse then branch. if else branch exists, parse that too.
-    std::shared_ptr<Stmt> thenBranch = statement();
-    std::shared_ptr<Stmt> elseBranch = nullptr;
+    Stmt* thenBranch = statement();
+    Stmt* elseBranch = nullptr;
     if (match(Token::ELSE)) elseBranch = statement();
 
-    return std::make_shared<IfStmt>(condition, thenBranch, elseBranch);
+    return arena.make<IfStmt>(condition, thenBranch, elseBranch);
 }
-std::shared_ptr<Stmt> StmtParser::whileStatement(){
+Stmt* StmtParser::whileStatement(){
     consume(Token::LEFT_PAREN, "Expect '(' after 'while'.");
-    std::shared_ptr<Expr> condition = expression();
+    Expr* condition = expression();
     consume(Token::RIGHT_PAREN, "Expect ')' after while condition.");
-    std::shared_ptr<Stmt> body = statement();
+    Stmt* body = statement();
 
-    return std::make_shared<WhileStmt>(condition, body);
+    return arena.make<WhileStmt>(condition, body);
 }
-std::shared_ptr<Stmt> StmtParser::forStatement(){
+Stmt* StmtParser::forStatement(){
     // desugaring. the for statement will be parsed as a while statement.
     // format:  for(initializer; condition; increment) body
 
@@ -142,24 +142,24 @@ std::shared_ptr<Stmt> StmtParser::forStatement(){
     consume(Token::LEFT_PAREN, "Expect '(' after 'for'");
 
     // valid initializer is either none (;), a variable declaration or an expression statement
-    std::shared_ptr<Stmt> initializer;
+    Stmt* initializer;
     if (match(Token::SEMICOLON)) initializer = nullptr;
     else if (match(Token::VAR)) initializer = varDeclaration();
     else initializer = exprStatement();
 
     // valid condition is either none (;) or an expression statement
     // the semicolon is consumed.
-    std::shared_ptr<Expr> condition = nullptr;
+    Expr* condition = nullptr;
     if (!check(Token::SEMICOLON)) condition = expression();
     consume(Token::SEMICOLON, "Expect ';' after loop condition.");
 
     // valid incrementer is either none () or an expression
-    std::shared_ptr<Expr> increment = nullptr;
+    Expr* increment = nullptr;
     if (!check(Token::RIGHT_PAREN)) increment = expression();
     consume(Token::RIGHT_PAREN, "Expect ')' after for clauses.");
 
     // body of for loop
-    std::shared_ptr<Stmt> body = statement();
+    Stmt* body = statement();
 
     // compilation of for loop to while loop:
     /*  {
@@ -172,72 +172,74 @@ std::shared_ptr<Stmt> StmtParser::forStatement(){
 
     // if there is an increment, enclose body and increment in new Block
     if (increment){
-        std::vector<std::shared_ptr<Stmt>> v = {body, std::make_shared<ExpressionStmt>(increment)};
-        body = std::make_shared<BlockStmt>(v);
+        std::vector<Stmt*> v = {body, arena.make<ExpressionStmt>(increment)};
+        body = arena.make<BlockStmt>(v);
     }
 
     // if there is no condition, assume while(true). create While.
-    if (!condition) condition = std::make_shared<LiteralExpr>(Object::boolean(1));
-    std::shared_ptr<Stmt> whileBlock = std::make_shared<WhileStmt>(condition, body);
+    if (!condition) condition = arena.make<LiteralExpr>(Object::boolean(1));
+    Stmt* whileBlock = arena.make<WhileStmt>(condition, body);
 
     // if there is an initializer, enclose whileBlock and initializer in new Block
     if (initializer){
-        std::vector<std::shared_ptr<Stmt>> v = {initializer, whileBlock};
-        whileBlock = std::make_shared<BlockStmt>(v);
+        std::vector<Stmt*> v = {initializer, whileBlock};
+        whileBlock = arena.make<BlockStmt>(v);
     }
 
     return whileBlock;
 }
 
 // ---FUNCTIONS AND CLASSES---
-std::shared_ptr<FunctionStmt> StmtParser::functionDeclaration(std::string kind){
-    Token name = consume(Token::IDENTIFIER, "Expect " + kind + " name.");
+FunctionStmt* StmtParser::functionDeclaration(std::string kind){
+    const Token& name = consume(Token::IDENTIFIER, "Expect " + kind + " name.");
     consume(Token::LEFT_PAREN, "Expect '(' after " + kind + " name.");
 
     // parse parameters
-    std::vector<Token> parameters = {};
+    std::vector<const Token*> parameters = {};
     if (!check(Token::RIGHT_PAREN)){
         do{
             if (parameters.size() >= 255)
                 error(peek(), "Can't have more than 255 arguments.");
-            parameters.push_back(consume(Token::IDENTIFIER, "Expect variable name."));
+            parameters.push_back(&consume(Token::IDENTIFIER, "Expect variable name."));
         } while(match(Token::COMMA));
     }
     consume(Token::RIGHT_PAREN, "Expect ')' after parameters.");
 
     // block() expects the opening brace to be consumed
     consume(Token::LEFT_BRACE, "Expect '{' before " + kind + " body.");
-    std::vector<std::shared_ptr<Stmt>> body = block();
+    std::vector<Stmt*> body = block();
 
-    return std::make_shared<FunctionStmt>(name, parameters, body);
+    // the program must be kept for as long as the function may be called
+    arena.hasFunctions = true;
+    return arena.make<FunctionStmt>(name, parameters, body);
 }
-std::shared_ptr<Stmt> StmtParser::returnStatement(){
-    Token keyword = previous();
-    std::shared_ptr<Expr> expr = nullptr;
+Stmt* StmtParser::returnStatement(){
+    const Token& keyword = previous();
+    Expr* expr = nullptr;
     if (!check(Token::SEMICOLON)) expr = expression();
     consume(Token::SEMICOLON, "Expect ';' after return value.");
 
-    return std::make_shared<ReturnStmt>(keyword, expr);
+    return arena.make<ReturnStmt>(keyword, expr);
 }
-std::shared_ptr<Stmt> StmtParser::classDeclaration(){
+Stmt* StmtParser::classDeclaration(){
     // consume name, optionally consume superclass this inherits from
-    Token name = consume(Token::IDENTIFIER, "Expect class name.");
+    const Token& name = consume(Token::IDENTIFIER, "Expect class name.");
 
-    std::shared_ptr<VariableExpr> superclass = nullptr;
+    VariableExpr* superclass = nullptr;
     if (match(Token::LESS)){
         consume(Token::IDENTIFIER, "Expect superclass name.");
-        superclass = std::make_shared<VariableExpr>(previous());
+        superclass = arena.make<VariableExpr>(previous());
     }
 
     consume(Token::LEFT_BRACE, "Expect '{' before class body");
 
     // consume all methods.
-    std::vector<std::shared_ptr<FunctionStmt>> methods = {};
+    std::vector<FunctionStmt*> methods = {};
     while (!isAtEnd() && !check(Token::RIGHT_BRACE)){
         methods.push_back(functionDeclaration("method"));
     }
 
     consume(Token::RIGHT_BRACE, "Expect '}' after class body.");
 
-    return std::make_shared<ClassStmt>(name, superclass, methods);
+    return arena.make<ClassStmt>(name, superclass, methods);
 }
\ No newline at end of file
@@ -24,19 +24,19 @@ block          → "{" declaration* "}" ;
 
 class StmtParser : public ExprParser{
     public:
-        StmtParser(std::vector<Token> tokens) : ExprParser(tokens) {}
-        std::vector<std::shared_ptr<Stmt>> parse(bool parseExpr = false);
+        StmtParser(AstArena& arena) : ExprParser(arena) {}
+        std::vector<Stmt*> parse(bool parseExpr = false);
     protected:
-        std::shared_ptr<Stmt> declaration(void);
-        std::shared_ptr<FunctionStmt> functionDeclaration(std::string kind);
-        std::shared_ptr<Stmt> classDeclaration(void);
-        std::shared_ptr<Stmt> varDeclaration(void);
-        std::shared_ptr<Stmt> statement(void);
-        std::shared_ptr<Stmt> exprStatement(void);
-        std::shared_ptr<Stmt> printStatement(void);
-        std::vector<std::shared_ptr<Stmt>> block(void);
-        std::shared_ptr<Stmt> ifStatement(void);
-        std::shared_ptr<Stmt> whileStatement(void);
-        std::shared_ptr<Stmt> forStatement(void);
-        std::shared_ptr<Stmt> returnStatement(void);
+        Stmt* declaration(void);
+        FunctionStmt* functionDeclaration(std::string kind);
+        Stmt* classDeclaration(void);
+        Stmt* varDeclaration(void);
+        Stmt* statement(void);
+        Stmt* exprStatement(void);
+        Stmt* printStatement(void);
+        std::vector<Stmt*> block(void);
+        Stmt* ifStatement(void);
+        Stmt* whileStatement(void);
+        Stmt* forStatement(void);
+        Stmt* returnStatement(void);
 };
\ No newline at end of file
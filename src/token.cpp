@@ -1,9 +1,11 @@
 #include "token.hpp"
 
-// include LoxCallable, LoxClass and LoxInstance.
+// include LoxString, LoxCallable, LoxClass and LoxInstance.
 // required for implementation details.
+#include "loxString.hpp"
 #include "loxCallable.hpp"
 #include "loxClass.hpp"
+#include "loxFunction.hpp"
 
 std::unordered_map<Token::TokenType,std::string> Token::tokenTypeName = {
     {LEFT_PAREN, "LEFT_PAREN"}, 
@@ -73,28 +75,19 @@ bool isAlphaNumeric (const char c){
     ...
 */
 
-Object Object::nil(){
-    Object obj;
-    obj.type = Object::NIL;
-    return obj;
+Object::Object(ObjectType type, LoxObject* obj) : type(type), obj(obj) {
+    // takes a reference to a heap object. obj must not be nullptr
+    obj->retain();
 }
-Object Object::boolean(bool b){
-    Object obj;
-    obj.type = Object::BOOL;
-    obj.literalBool = b;
-    return obj;
+
+Object Object::string(std::string s){
+    return Object(Object::STRING, LoxString::intern(std::move(s)).get());
 }
-Object Object::number(double val){
-    Object obj;
-    obj.type = Object::NUMBER;
-    obj.literalNumber = val;
-    return obj;
+Object Object::string(Ref<LoxString> str){
+    return Object(Object::STRING, str.get());
 }
-Object Object::string(std::string s){
-    Object obj;
-    obj.type = Object::STRING;
-    obj.literalString = s;
-    return obj;
+Object Object::rope(Ref<LoxRope> rope){
+    return Object(Object::ROPE, rope.get());
 }
 std::string Object::toString(bool useLox){
     switch(type){
@@ -112,14 +105,12 @@ std::string Object::toString(bool useLox){
                 str.erase(str.find_last_not_of('0') + 1, std::string::npos);
                 return str;
             }
-        case Object::STRING: 
-            return literalString;
+        case Object::STRING:
+        case Object::ROPE:
         case Object::LOX_CALLABLE:
-            return loxFunction->toString();
         case Object::LOX_CLASS:
-            return loxClass->toString();
         case Object::LOX_INSTANCE:
-            return loxInstance->toString();
+            return obj->toString();
 
         default:
             throw "UNIMPLEMENTED toString type!";
@@ -128,23 +119,17 @@ std::string Object::toString(bool useLox){
     return "";
 }
 
-Object Object::function(std::shared_ptr<LoxCallable> func){
-    Object obj;
-    obj.type = Object::LOX_CALLABLE;
-    obj.loxFunction = func;
-    return obj;
+Object Object::function(Ref<LoxCallable> func){
+    return Object(Object::LOX_CALLABLE, func.get());
+}
+Object Object::klass(Ref<LoxClass> loxClass){
+    return Object(Object::LOX_CLASS, loxClass.get());
 }
-Object Object::klass(std::shared_ptr<LoxClass> loxClass){
-    Object obj;
-    obj.type = Object::LOX_CLASS;
-    obj.loxClass = loxClass;
-    return obj;
+Object Object::instance(Ref<LoxInstance> loxInstance){
+    return Object(Object::LOX_INSTANCE, loxInstance.get());
 }
-Object Object::instance(std::shared_ptr<LoxInstance> loxInstance){
-    Object obj;
-    obj.type = Object::LOX_INSTANCE;
-    obj.loxInstance = loxInstance;
-    return obj;
+Object Object::upvalue(Ref<LoxUpvalue> upvalue){
+    return Object(Object::UPVALUE, upvalue.get());
 }
 
 
@@ -6,19 +6,25 @@
 #include <unordered_map>
 #include <cmath>
 
-// required for smart pointers
-#include <memory>
+// required for fixed-width integers
+#include <cstdint>
+
+// required for reference-counted heap objects
+#include "loxObject.hpp"
 
 #pragma once
 
-// LoxCallable, LoxClass and LoxInstance are included in the .cpp file and
+// LoxString, LoxCallable, LoxClass and LoxInstance are included in the .cpp file and
 // are SEPARATELY DECLARED defined in the .hpp file.
 // this is to avoid circular dependencies.
-// As Object methods are not defined in header files, and are only needed for smart pointers
+// As Object methods are not defined in header files, and are only needed for pointers
 // no implementation details of the classes themselves is required.
+class LoxString;
+class LoxRope;
 class LoxCallable;
 class LoxClass;
 class LoxInstance;
+class LoxUpvalue;
 
 /*
     HEADER FILES SHOUD DECLARE:
@@ -39,30 +45,90 @@ bool isAlphaNumeric(const char c);
 class Object {
     // Wrapper class to represent an arbitrary literal
     // Pass by value for all subsequent use
+    // Tagged value: one type tag and one 8-byte payload, 16 bytes in total.
+    // Heap types (STRING and above) hold a counted reference to a LoxObject.
     public:
-        enum ObjectType {
-            NIL, NUMBER, STRING, BOOL,
+        enum ObjectType : std::uint8_t {
+            NIL, BOOL, NUMBER,
+            // heap-allocated types. keep these last, see isObj()
+            // STRING is flat and interned; ROPE is a lazy concatenation, see LoxRope
+            STRING, ROPE,
             LOX_CALLABLE,
-            LOX_CLASS, LOX_INSTANCE
+            LOX_CLASS, LOX_INSTANCE,
+            // internal: the box of a captured local variable. only ever stored in a call frame,
+            // and never seen by Lox code (see VariableSlot::BOXED)
+            UPVALUE
         };
         ObjectType type;
-        bool literalBool;
-        double literalNumber;
-        std::string literalString;
-        std::shared_ptr<LoxCallable> loxFunction;
-        std::shared_ptr<LoxClass> loxClass;
-        std::shared_ptr<LoxInstance> loxInstance;
+        union {
+            bool literalBool;
+            double literalNumber;
+            LoxObject* obj;
+            std::uint64_t bits;    // used to copy the payload regardless of type
+        };
+
+        Object(void) : type(NIL), bits(0) {}
+        Object(const Object& other) : type(other.type), bits(other.bits) {
+            if (isObj()) obj->retain();
+        }
+        Object(Object&& other) noexcept : type(other.type), bits(other.bits) {
+            other.type = NIL;
+        }
+        Object& operator=(const Object& other){
+            if (other.isObj()) other.obj->retain();
+            if (isObj()) obj->release();
+            type = other.type;
+            bits = other.bits;
+            return *this;
+        }
+        Object& operator=(Object&& other) noexcept {
+            if (this != &other){
+                if (isObj()) obj->release();
+                type = other.type;
+                bits = other.bits;
+                other.type = NIL;
+            }
+            return *this;
+        }
+        ~Object(void){
+            if (isObj()) obj->release();
+        }
+
+        bool isObj(void) const { return type >= STRING; }
+        bool isString(void) const { return type == STRING || type == ROPE; }
+        // reports the heap payload (if any) to a HeapVisitor
+        void trace(HeapVisitor& visitor) const { if (isObj()) visitor.visit(obj); }
+        // unchecked downcast of the heap payload. check type beforehand.
+        template<typename T>
+        T* as(void) const { return static_cast<T*>(obj); }
 
         std::string toString(bool useLox = false);
         
-        // Generator functions
-        static Object nil(void);
-        static Object boolean(bool b);
-        static Object number(double val);
+        // Generator functions. those of values without a payload on the heap are inline,
+        // as arithmetic and comparisons create one for every result
+        static Object nil(void){ return Object(); }
+        static Object boolean(bool b){
+            Object obj;
+            obj.type = BOOL;
+            obj.literalBool = b;
+            return obj;
+        }
+        static Object number(double val){
+            Object obj;
+            obj.type = NUMBER;
+            obj.literalNumber = val;
+            return obj;
+        }
         static Object string(std::string str);
-        static Object function(std::shared_ptr<LoxCallable> func);
-        static Object klass(std::shared_ptr<LoxClass> loxClass);
-        static Object instance(std::shared_ptr<LoxInstance> loxInstance);
+        static Object string(Ref<LoxString> str);
+        static Object rope(Ref<LoxRope> rope);
+        static Object function(Ref<LoxCallable> func);
+        static Object klass(Ref<LoxClass> loxClass);
+        static Object instance(Ref<LoxInstance> loxInstance);
+        static Object upvalue(Ref<LoxUpvalue> upvalue);
+
+    private:
+        Object(ObjectType type, LoxObject* obj);
 };
 
 class Token {
@@ -0,0 +1,419 @@
+#include "vm.hpp"
+
+// required to hand the arguments of a native call over in place
+#include <span>
+
+void VM::interpret(Chunk* program, int frameSize){
+    // executes a compiled program in a frame of [frameSize] slots (locals of top-level blocks)
+    // the stack is cleared afterwards, even on a RuntimeError
+    interpreter.stack.resize(frameSize + program->maxStack);
+    interpreter.frameBase = 0;
+    interpreter.closure = nullptr;
+    frames.push_back(Frame{nullptr, nullptr, program, program->code.data(), 0, 0});
+    try{
+        run();
+    }
+    catch(...){
+        reset();
+        throw;
+    }
+    reset();
+}
+void VM::reset(void){
+    frames.clear();
+    interpreter.stack.clear();
+    interpreter.frameBase = 0;
+    interpreter.closure = nullptr;
+}
+
+Object* VM::call(Object* callee, size_t arguments, CallExpr* curr){
+    // calls [callee] on the [arguments] above it. returns the new top of the stack:
+    // either above the result (classes without 'init', native functions),
+    // or above the frame pushed for the call
+    std::vector<Object>& stack = interpreter.stack;
+
+    // the call site caches the callee it last called, with its arity checked (see CallCache)
+    LoxCallable* const callable = interpreter.checkCall(curr, *callee, arguments);
+    LoxFunction* const function = curr->cache.function;
+
+    // a class creates an instance, which replaces the class as 'this' of its initializer (if any)
+    if (callee->type == Object::LOX_CLASS){
+        LoxClass* const loxClass = callee->as<LoxClass>();
+        Ref<LoxInstance> instance = makeRef<LoxInstance>(loxClass);
+        Ref<LoxFunction> initializer = loxClass->initializer;
+        *callee = Object::instance(instance);
+        if (!initializer) return callee + 1;
+        if (frames.size() > maxDepth) throw interpreter.error(curr->paren, "Stack overflow.");
+        const size_t calleeIndex = callee - stack.data();
+        return enter(initializer.get(), instance.get(), calleeIndex, calleeIndex);
+    }
+
+    if (!function){
+        // native functions, on the arguments in place (they do not call back into Lox)
+        Object result = callable->call(interpreter, std::span<Object>(callee + 1, arguments));
+        for (Object* slot = callee + 1; slot <= callee + arguments; slot++) *slot = Object::nil();
+        *callee = std::move(result);
+        return callee + 1;
+    }
+
+    FunctionStmt* const declaration = function->declaration;
+    if (frames.size() > maxDepth) throw interpreter.error(curr->paren, "Stack overflow.");
+
+    // the arguments are already in place: methods have 'this' in slot 0, in place of the callee
+    const size_t calleeIndex = callee - stack.data();
+    return enter(function, function->receiver.get(), calleeIndex, declaration->isMethod ? calleeIndex : calleeIndex + 1);
+}
+Object* VM::invoke(Object* callee, size_t arguments, CallExpr* curr){
+    // calls a method (see GET_METHOD): [callee] is the method, followed by its receiver,
+    // which is slot 0 of the frame. a property that is not a method is followed by nil instead,
+    // and called as a value
+    if (callee[1].type == Object::NIL){
+        dropReceiver(callee, arguments);
+        return call(callee, arguments, curr);
+    }
+    LoxFunction* const function = callee->as<LoxFunction>();
+    if (arguments != function->declaration->params.size()) interpreter.checkCall(curr, *callee, arguments);
+    if (frames.size() > maxDepth) throw interpreter.error(curr->paren, "Stack overflow.");
+
+    const size_t calleeIndex = callee - interpreter.stack.data();
+    return enter(function, callee[1].as<LoxInstance>(), calleeIndex, calleeIndex + 1);
+}
+Object* VM::enter(LoxFunction* function, LoxInstance* receiver, size_t callee, size_t base){
+    // pushes the frame of a call, with slot 0 at [base]. the result replaces [callee]
+    std::vector<Object>& stack = interpreter.stack;
+    Chunk* const chunk = function->declaration->chunk;
+    const size_t top = base + chunk->frameSize + chunk->maxStack;
+    if (top > stack.size()) stack.resize(std::max(top, 2 * stack.size()));
+
+    Object* const slots = stack.data() + base;
+    Ref<LoxFunction> ref = function;
+    if (function->declaration->isMethod) slots[0] = Object::instance(receiver);
+    for (std::uint32_t slot : chunk->boxed)
+        slots[slot] = Object::upvalue(makeRef<LoxUpvalue>(std::move(slots[slot])));
+
+    frames.push_back(Frame{std::move(ref), receiver, chunk, chunk->code.data(), base, callee});
+    return slots + chunk->frameSize;
+}
+void VM::dropReceiver(Object* callee, size_t arguments){
+    // moves the arguments of an INVOKE down over the receiver slot (nil), as for a CALL
+    for (size_t i = 1; i <= arguments; i++) callee[i] = std::move(callee[i + 1]);
+    callee[arguments + 1] = Object::nil();
+}
+
+Object* VM::tailCall(Object* callee, size_t arguments, CallExpr* curr){
+    // a user-defined function replaces the frame of the caller: it is moved down
+    // in place of the caller's callee, with its arguments. anything else is a CALL,
+    // and the RETURN that follows returns its result
+    interpreter.checkCall(curr, *callee, arguments);
+    if (!curr->cache.function) return call(callee, arguments, curr);
+
+    Object* const top = callee + arguments + 1;
+    Object* const target = interpreter.stack.data() + frames.back().callee;
+    for (size_t i = 0; i <= arguments; i++) target[i] = std::move(callee[i]);
+    for (Object* slot = target + arguments + 1; slot < top; slot++) *slot = Object::nil();
+    frames.pop_back();
+    return call(target, arguments, curr);
+}
+Object* VM::tailInvoke(Object* callee, size_t arguments, CallExpr* curr){
+    // as tailCall, for an INVOKE: the method is moved down with its receiver
+    if (callee[1].type == Object::NIL){
+        dropReceiver(callee, arguments);
+        return tailCall(callee, arguments, curr);
+    }
+    LoxFunction* const function = callee->as<LoxFunction>();
+    if (arguments != function->declaration->params.size()) interpreter.checkCall(curr, *callee, arguments);
+
+    Object* const top = callee + arguments + 2;
+    Object* const target = interpreter.stack.data() + frames.back().callee;
+    for (size_t i = 0; i <= arguments + 1; i++) target[i] = std::move(callee[i]);
+    for (Object* slot = target + arguments + 2; slot < top; slot++) *slot = Object::nil();
+    frames.pop_back();
+    return invoke(target, arguments, curr);
+}
+
+void VM::run(void){
+    std::vector<Object>& stack = interpreter.stack;
+    Frame* frame = nullptr;
+    Chunk* chunk = nullptr;
+    const std::uint8_t* ip = nullptr;
+    Object* slots = nullptr;
+    Object* sp = nullptr;
+
+    // the registers of the current frame. reloaded after every call and return,
+    // which may push or pop frames and grow the stack
+    #define VM_LOAD_FRAME()                                     \
+        frame = &frames.back();                                 \
+        chunk = frame->chunk;                                   \
+        ip = frame->ip;                                         \
+        slots = stack.data() + frame->base;                     \
+        interpreter.frameBase = frame->base;                    \
+        interpreter.closure = frame->function.get()
+
+    #define VM_READ_BYTE() (ip += 1, ip[-1])
+    #define VM_READ_LONG() (ip += 4, (std::uint32_t)ip[-4] | (std::uint32_t)ip[-3] << 8 \
+        | (std::uint32_t)ip[-2] << 16 | (std::uint32_t)ip[-1] << 24)
+    #define VM_EXPR(T) static_cast<T*>(chunk->exprs[VM_READ_LONG()])
+
+    VM_LOAD_FRAME();
+    sp = slots + chunk->frameSize;
+
+    // threaded dispatch: every instruction jumps straight to the next one's handler
+    #if defined(__GNUC__)
+        static void* const dispatch[] = {
+            #define LOX_OPCODE_LABEL(name, effect) &&op_##name,
+            LOX_OPCODES(LOX_OPCODE_LABEL)
+            #undef LOX_OPCODE_LABEL
+        };
+        #define VM_DISPATCH() goto *dispatch[*ip++]
+        #define VM_CASE(name) op_##name
+        VM_DISPATCH();
+    #else
+        #define VM_DISPATCH() continue
+        #define VM_CASE(name) case OP_##name
+        for (;;) switch (*ip++)
+    #endif
+    {
+        // constants
+        VM_CASE(CONSTANT):
+            *sp++ = chunk->constants[VM_READ_LONG()];
+            VM_DISPATCH();
+        VM_CASE(NIL):
+            *sp++ = Object::nil();
+            VM_DISPATCH();
+        VM_CASE(TRUE):
+            *sp++ = Object::boolean(true);
+            VM_DISPATCH();
+        VM_CASE(FALSE):
+            *sp++ = Object::boolean(false);
+            VM_DISPATCH();
+        VM_CASE(POP):
+            *--sp = Object::nil();
+            VM_DISPATCH();
+
+        // variables
+        VM_CASE(GET_LOCAL):
+            *sp = slots[VM_READ_LONG()];
+            sp++;
+            VM_DISPATCH();
+        VM_CASE(SET_LOCAL):
+            slots[VM_READ_LONG()] = sp[-1];
+            VM_DISPATCH();
+        VM_CASE(STORE_LOCAL):
+            slots[VM_READ_LONG()] = std::move(*--sp);
+            VM_DISPATCH();
+        VM_CASE(GET_BOXED):
+            *sp = slots[VM_READ_LONG()].as<LoxUpvalue>()->value;
+            sp++;
+            VM_DISPATCH();
+        VM_CASE(SET_BOXED):
+            slots[VM_READ_LONG()].as<LoxUpvalue>()->value = sp[-1];
+            VM_DISPATCH();
+        VM_CASE(DEFINE_BOXED):{
+            const std::uint32_t slot = VM_READ_LONG();
+            slots[slot] = Object::upvalue(makeRef<LoxUpvalue>(std::move(*--sp)));
+            VM_DISPATCH();
+        }
+        VM_CASE(GET_UPVALUE):
+            *sp = frame->function->upvalues[VM_READ_LONG()]->value;
+            sp++;
+            VM_DISPATCH();
+        VM_CASE(SET_UPVALUE):
+            frame->function->upvalues[VM_READ_LONG()]->value = sp[-1];
+            VM_DISPATCH();
+        VM_CASE(GET_GLOBAL):
+            *sp = interpreter.globalVariable(VM_EXPR(VariableExpr));
+            sp++;
+            VM_DISPATCH();
+        VM_CASE(SET_GLOBAL):
+            interpreter.assign(VM_EXPR(AssignExpr), sp[-1]);
+            VM_DISPATCH();
+        VM_CASE(DEFINE_GLOBAL):{
+            const std::uint32_t slot = VM_READ_LONG();
+            interpreter.defineGlobal(slot, std::move(*--sp));
+            VM_DISPATCH();
+        }
+
+        // operators. numbers take the fast path, in place;
+        // everything else (string concatenation, type errors) is left to Interpreter::binary
+        #define VM_ARITHMETIC(name, symbol)                                                         \
+            VM_CASE(name):{                                                                     \
+                const std::uint32_t index = VM_READ_LONG();                                     \
+                if (sp[-2].type == Object::NUMBER && sp[-1].type == Object::NUMBER){            \
+                    sp[-2].literalNumber = sp[-2].literalNumber symbol sp[-1].literalNumber;        \
+                    sp--;                                                                       \
+                    VM_DISPATCH();                                                              \
+                }                                                                               \
+                sp[-2] = interpreter.binary(static_cast<BinaryExpr*>(chunk->exprs[index])->op, sp[-2], sp[-1]); \
+                *--sp = Object::nil();                                                          \
+                VM_DISPATCH();                                                                  \
+            }
+        #define VM_COMPARISON(name, symbol)                                                         \
+            VM_CASE(name):{                                                                     \
+                const std::uint32_t index = VM_READ_LONG();                                     \
+                if (sp[-2].type == Object::NUMBER && sp[-1].type == Object::NUMBER){            \
+                    sp[-2] = Object::boolean(sp[-2].literalNumber symbol sp[-1].literalNumber);     \
+                    sp--;                                                                       \
+                    VM_DISPATCH();                                                              \
+                }                                                                               \
+                sp[-2] = interpreter.binary(static_cast<BinaryExpr*>(chunk->exprs[index])->op, sp[-2], sp[-1]); \
+                *--sp = Object::nil();                                                          \
+                VM_DISPATCH();                                                                  \
+            }
+        VM_CASE(EQUAL):
+            sp[-2] = Object::boolean(interpreter.isEqual(sp[-2], sp[-1]));
+            *--sp = Object::nil();
+            VM_DISPATCH();
+        VM_CASE(NOT_EQUAL):
+            sp[-2] = Object::boolean(!interpreter.isEqual(sp[-2], sp[-1]));
+            *--sp = Object::nil();
+            VM_DISPATCH();
+        VM_COMPARISON(GREATER, >)
+        VM_COMPARISON(GREATER_EQUAL, >=)
+        VM_COMPARISON(LESS, <)
+        VM_COMPARISON(LESS_EQUAL, <=)
+        VM_ARITHMETIC(ADD, +)
+        VM_ARITHMETIC(SUBTRACT, -)
+        VM_ARITHMETIC(MULTIPLY, *)
+        VM_ARITHMETIC(DIVIDE, /)
+        #undef VM_ARITHMETIC
+        #undef VM_COMPARISON
+        VM_CASE(NOT):
+            sp[-1] = Object::boolean(!interpreter.isTruthy(sp[-1]));
+            VM_DISPATCH();
+        VM_CASE(NEGATE):{
+            UnaryExpr* curr = VM_EXPR(UnaryExpr);
+            if (sp[-1].type == Object::NUMBER) sp[-1].literalNumber = -sp[-1].literalNumber;
+            else interpreter.unary(curr->op, sp[-1]);
+            VM_DISPATCH();
+        }
+
+        // statements and control flow
+        VM_CASE(PRINT):
+            interpreter.print(std::move(*--sp));
+            VM_DISPATCH();
+        VM_CASE(JUMP):{
+            const std::uint32_t offset = VM_READ_LONG();
+            ip += offset;
+            VM_DISPATCH();
+        }
+        VM_CASE(JUMP_IF_FALSE):{
+            const std::uint32_t offset = VM_READ_LONG();
+            if (!interpreter.isTruthy(sp[-1])) ip += offset;
+            VM_DISPATCH();
+        }
+        VM_CASE(JUMP_IF_TRUE):{
+            const std::uint32_t offset = VM_READ_LONG();
+            if (interpreter.isTruthy(sp[-1])) ip += offset;
+            VM_DISPATCH();
+        }
+        VM_CASE(POP_JUMP_IF_FALSE):{
+            const std::uint32_t offset = VM_READ_LONG();
+            if (!interpreter.isTruthy(sp[-1])) ip += offset;
+            *--sp = Object::nil();
+            VM_DISPATCH();
+        }
+        VM_CASE(LOOP):{
+            const std::uint32_t offset = VM_READ_LONG();
+            ip -= offset;
+            VM_DISPATCH();
+        }
+
+        // functions and classes
+        VM_CASE(CALL):{
+            const size_t arguments = VM_READ_BYTE();
+            CallExpr* curr = VM_EXPR(CallExpr);
+            frame->ip = ip;
+            sp = call(sp - arguments - 1, arguments, curr);
+            VM_LOAD_FRAME();
+            VM_DISPATCH();
+        }
+        VM_CASE(TAIL_CALL):{
+            const size_t arguments = VM_READ_BYTE();
+            CallExpr* curr = VM_EXPR(CallExpr);
+            frame->ip = ip;
+            sp = tailCall(sp - arguments - 1, arguments, curr);
+            VM_LOAD_FRAME();
+            VM_DISPATCH();
+        }
+        VM_CASE(INVOKE):{
+            const size_t arguments = VM_READ_BYTE();
+            CallExpr* curr = VM_EXPR(CallExpr);
+            frame->ip = ip;
+            sp = invoke(sp - arguments - 2, arguments, curr);
+            VM_LOAD_FRAME();
+            VM_DISPATCH();
+        }
+        VM_CASE(TAIL_INVOKE):{
+            const size_t arguments = VM_READ_BYTE();
+            CallExpr* curr = VM_EXPR(CallExpr);
+            frame->ip = ip;
+            sp = tailInvoke(sp - arguments - 2, arguments, curr);
+            VM_LOAD_FRAME();
+            VM_DISPATCH();
+        }
+        VM_CASE(RETURN):{
+            // the result replaces the callee; the frame and everything above it is cleared
+            // initializers return 'this'
+            Object result = std::move(*--sp);
+            if (frame->function->isInitializer) result = Object::instance(frame->receiver);
+            Object* const callee = stack.data() + frame->callee;
+            for (Object* slot = callee; slot < sp; slot++) *slot = Object::nil();
+            *callee = std::move(result);
+            sp = callee + 1;
+            frames.pop_back();
+            VM_LOAD_FRAME();
+            VM_DISPATCH();
+        }
+        VM_CASE(FUNCTION):
+            interpreter.visitFunctionStmt(static_cast<FunctionStmt*>(chunk->stmts[VM_READ_LONG()]));
+            VM_DISPATCH();
+        VM_CASE(CLASS):
+            interpreter.visitClassStmt(static_cast<ClassStmt*>(chunk->stmts[VM_READ_LONG()]));
+            VM_DISPATCH();
+        VM_CASE(GET_PROPERTY):{
+            GetExpr* curr = VM_EXPR(GetExpr);
+            sp[-1] = interpreter.getProperty(curr, sp[-1]);
+            VM_DISPATCH();
+        }
+        VM_CASE(GET_METHOD):{
+            // the method invoked by the INVOKE that follows, below the object (its receiver)
+            // anything else is the value of the property, below nil
+            GetExpr* curr = VM_EXPR(GetExpr);
+            LoxFunction* method = interpreter.invokedMethod(curr, sp[-1]);
+            if (method){
+                *sp = std::move(sp[-1]);
+                sp[-1] = Object::function(method);
+            }
+            else{
+                sp[-1] = interpreter.getProperty(curr, sp[-1]);
+                *sp = Object::nil();
+            }
+            sp++;
+            VM_DISPATCH();
+        }
+        VM_CASE(CHECK_INSTANCE):
+            interpreter.checkInstance(VM_EXPR(SetExpr), sp[-1]);
+            VM_DISPATCH();
+        VM_CASE(SET_PROPERTY):{
+            SetExpr* curr = VM_EXPR(SetExpr);
+            interpreter.setProperty(curr, sp[-2], sp[-1]);
+            sp[-2] = std::move(sp[-1]);
+            sp--;
+            VM_DISPATCH();
+        }
+        VM_CASE(SUPER):
+            *sp = interpreter.visitSuperExpr(VM_EXPR(SuperExpr));
+            sp++;
+            VM_DISPATCH();
+        VM_CASE(HALT):
+            frame->ip = ip;
+            return;
+    }
+
+    #undef VM_LOAD_FRAME
+    #undef VM_READ_BYTE
+    #undef VM_READ_LONG
+    #undef VM_EXPR
+    #undef VM_DISPATCH
+    #undef VM_CASE
+}
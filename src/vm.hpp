@@ -0,0 +1,56 @@
+// requires the Interpreter, whose state (globals, frames) and operations are shared
+#include "interpreter.hpp"
+// shares the default depth limit of the StacklessInterpreter
+#include "stacklessInterpreter.hpp"
+// requires the instruction set and chunks
+#include "chunk.hpp"
+
+#pragma once
+
+class VM{
+    // Executes bytecode compiled by BytecodeCompiler, one instruction at a time.
+    // Temporaries live on the same stack as the locals: a call leaves its callee and arguments
+    // on top of the stack, and the arguments become the first slots of the callee's frame
+    // without being copied. Every Lox call pushes a Frame, not a native call.
+    /*
+        KEY NOTES:
+        1. Shares its state with an Interpreter: globals, Interpreter::stack, and the work of
+           the instructions that are not on a fast path (Interpreter::binary, ::getProperty, ...).
+           Interpreter::frameBase and ::closure follow the current frame, so that
+           declarations (FUNCTION, CLASS) run through the Interpreter unchanged.
+        2. Slots of Interpreter::stack above the top hold no heap references.
+        3. A call deeper than [maxDepth] frames throws a RuntimeError ("Stack overflow.").
+           Tail calls (TAIL_CALL, TAIL_INVOKE) replace the frame of the caller, and do not count.
+        4. 'object.name(...)' calls the method unbound (GET_METHOD, INVOKE): the method and
+           its receiver take the place of the callee, and the receiver becomes slot 0 ('this')
+           of the method's frame. No bound method is created.
+        5. Dispatch is threaded (computed goto) where the compiler supports it.
+    */
+    public:
+        size_t maxDepth = StacklessInterpreter::defaultMaxDepth;
+
+        VM(Interpreter& interpreter) : interpreter(interpreter) {}
+        void interpret(Chunk* program, int frameSize);
+
+    private:
+        struct Frame{
+            // a call of a user-defined function (or the program itself, without a function)
+            Ref<LoxFunction> function;
+            LoxInstance* receiver;      // 'this' of a method, held by slot 0
+            Chunk* chunk;
+            const std::uint8_t* ip;     // next instruction, saved while the frame is calling
+            size_t base;                // slot 0 of the frame in Interpreter::stack
+            size_t callee;              // slot of the callee, where the result goes
+        };
+        Interpreter& interpreter;
+        std::vector<Frame> frames = {};
+
+        void run(void);
+        Object* call(Object* callee, size_t arguments, CallExpr* curr);
+        Object* invoke(Object* callee, size_t arguments, CallExpr* curr);
+        Object* tailCall(Object* callee, size_t arguments, CallExpr* curr);
+        Object* tailInvoke(Object* callee, size_t arguments, CallExpr* curr);
+        Object* enter(LoxFunction* function, LoxInstance* receiver, size_t callee, size_t base);
+        void dropReceiver(Object* callee, size_t arguments);
+        void reset(void);
+};